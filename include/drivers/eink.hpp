@@ -36,7 +36,11 @@ class EInk
     virtual inline void update(FrameBuffer1Bit & frame_buffer) = 0;
     virtual inline void update(FrameBuffer3Bit & frame_buffer) = 0;
 
-    virtual void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false) = 0;
+    // Only the frame buffer rows first_row to last_row (inclusive, last_row < 0
+    // meaning the last one) are compared to the screen content and updated.
+
+    virtual void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false,
+                                int16_t first_row = 0, int16_t last_row = -1) = 0;
 
     int8_t read_temperature();
 
@@ -77,7 +77,8 @@ class EInk6 : public EInk, NonCopyable
     void update(FrameBuffer1Bit & frame_buffer);
     void update(FrameBuffer3Bit & frame_buffer);
 
-    void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false);
+    void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false,
+                        int16_t first_row = 0, int16_t last_row = -1);
 
   private:
     static constexpr char const * TAG = "EInk6";
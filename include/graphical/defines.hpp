@@ -5,6 +5,15 @@
 
 enum class DisplayMode : uint8_t { INKPLATE_1BIT, INKPLATE_3BIT };
 
+// Raster operations of the blit engine, applied to the destination (d)
+// with the source (s) bits, a set bit being black:
+//
+//   COPY: s   OR: d | s   AND: d & s   XOR: d ^ s   NOT: ~s   AND_NOT: d & ~s
+enum class RasterOp : uint8_t { COPY, OR, AND, XOR, NOT, AND_NOT };
+
+// A rectangle, in logical (rotated) screen coordinates
+struct Rect { int16_t x, y, w, h; };
+
 constexpr uint8_t WHITE = 0;
 constexpr uint8_t BLACK = 1;
 
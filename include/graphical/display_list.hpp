@@ -0,0 +1,111 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __DISPLAY_LIST_HPP__
+#define __DISPLAY_LIST_HPP__
+
+#include <string>
+#include <vector>
+
+#include "graphics.hpp"
+
+/**
+ * @brief Retained mode drawing
+ *
+ * A list of items (shapes, text, bitmaps and canvases), drawn in the order
+ * they were added. Items are identified by the id returned when they are
+ * added, and can then be moved, recolored, hidden, removed, or have their
+ * text changed. Every change records the screen areas it damages (the item
+ * bounds before and after the change). render() redraws only these areas,
+ * with the clipping rectangle set to each of them, and refreshes them on the
+ * panel.
+ *
+ *   DisplayList list(display, WHITE);
+ *   auto clock = list.addText(10, 40, "12:00", &FreeSans24pt7b, BLACK);
+ *   list.render();
+ *   ...
+ *   list.setText(clock, "12:01");
+ *   list.render();
+ *
+ * Bitmaps and canvases are not copied: they must stay available as long as
+ * their item exists. When their content changes, call touch().
+ */
+class DisplayList
+{
+  public:
+    typedef uint16_t ItemId;
+
+    static constexpr ItemId NO_ITEM = 0;
+
+    DisplayList(Graphics & graphics, uint16_t background);
+
+    ItemId    addRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool filled = false);
+    ItemId    addLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color, uint8_t thickness = 1);
+    ItemId  addCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color, bool filled = false);
+    ItemId    addText(int16_t x, int16_t y, const std::string & text, const GFXfont * font, uint16_t color);
+    ItemId  addBitmap(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h, uint16_t color);
+    ItemId  addCanvas(int16_t x, int16_t y, const GFXcanvas8 * canvas, int16_t transparent = -1);
+
+    // The position is the top left corner for rectangles, bitmaps and
+    // canvases, the first end for lines, the center for circles and the
+    // cursor position (baseline) for text.
+
+    bool        moveTo(ItemId id, int16_t x, int16_t y);
+    bool      setColor(ItemId id, uint16_t color);
+    bool       setText(ItemId id, const std::string & text);
+    bool    setVisible(ItemId id, bool visible);
+    bool         touch(ItemId id);
+    bool        remove(ItemId id);
+    void         clear();
+
+    void    invalidate();
+    void setBackground(uint16_t color);
+
+    /**
+     * @brief Redraw the damaged areas
+     *
+     * @param update Refresh the panel: a partial update limited to the
+     *               damaged rows in 1-bit mode, a complete one in 3-bit mode.
+     * @return false if there was nothing to redraw.
+     */
+    bool render(bool update = true);
+
+    const std::vector<Rect> & getDamage() const { return damage; }
+
+  private:
+    enum class Kind : uint8_t { RECT, FILLED_RECT, LINE, CIRCLE, FILLED_CIRCLE, TEXT, BITMAP, CANVAS };
+
+    struct Item {
+      ItemId          id;
+      Kind            kind;
+      bool            visible;
+      int16_t         x, y;      // Position
+      int16_t         w, h;      // Size, second end of a line, or radius of a circle (w)
+      uint8_t         thickness; // Lines
+      int32_t         color;     // Transparent color for a canvas
+      std::string     text;
+      const GFXfont * font;
+      const void    * data;      // Bitmap or canvas
+      Rect            bounds;
+    };
+
+    // Above this count, the damaged areas are merged in a single one
+
+    static constexpr uint8_t MAX_DAMAGE = 8;
+
+    Graphics &        graphics;
+    uint16_t          background;
+    ItemId            next_id;
+    std::vector<Item> items;
+    std::vector<Rect> damage;
+
+    ItemId  add(Item & item);
+    Item * find(ItemId id);
+    void   setTextStyle(const Item & item);
+    void   setBounds(Item & item);
+    void   addDamage(const Rect & rect);
+    void   draw(const Item & item);
+};
+
+#endif
@@ -0,0 +1,154 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __FONT_FILE_HPP__
+#define __FONT_FILE_HPP__
+
+#include <cstdio>
+#include <list>
+#include <vector>
+
+#include "font_source.hpp"
+
+/**
+ * @brief Compressed font file, read a page at a time
+ *
+ * Fonts too large to be compiled in (multilingual sets, large sizes) are
+ * kept on the SD card in this format, generated by the
+ * tools/font_file_convert utility. The file starts with an index, loaded in
+ * memory when the file is opened: Unicode code point ranges, glyph metrics
+ * and pages location. The glyph bitmaps are grouped in pages of
+ * consecutive glyphs, each one possibly zlib compressed. An optional kerning
+ * table, also loaded in memory, follows the index. Pages are read and
+ * decompressed when one of their glyphs is needed, and kept in a least
+ * recently used cache of a bounded size.
+ *
+ *   FontFile font;
+ *   if (font.open("/sdcard/fonts/NotoSans-12.ipf")) {
+ *     display.setFontSource(&font);
+ *     display.print("Été, Ωμέγα");
+ *   }
+ *
+ * All values are little endian.
+ */
+class FontFile : public FontSource
+{
+  public:
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 32 * 1024; // Bytes
+
+    static constexpr char    MAGIC[4] = { 'I', 'P', 'F', 'T' };
+    static constexpr uint8_t VERSION  = 2;
+
+    enum class Compression : uint8_t { NONE = 0, ZLIB = 1 };
+
+    struct Header {
+      char     magic[4];
+      uint8_t  version;
+      uint8_t  bpp;              // 1, 2 or 4
+      uint8_t  y_advance;
+      uint8_t  compression;      // Compression
+      uint16_t range_count;
+      uint16_t page_count;
+      uint32_t glyph_count;
+      uint32_t kerning_count;    // Not in version 1 files
+    };
+
+    // Glyphs of a range have consecutive indexes, starting after the ones
+    // of the previous range. Ranges are in increasing code point order.
+
+    struct Range {
+      uint32_t first;            // Code point
+      uint32_t count;
+    };
+
+    // Bitmap rows start on a byte boundary
+
+    struct Glyph {
+      uint16_t offset;           // Of the bitmap in its (decompressed) page
+      uint8_t  width, height;
+      uint8_t  x_advance;
+      int8_t   x_offset, y_offset;
+      uint8_t  reserved;
+    };
+
+    struct Page {
+      uint32_t first_glyph;      // Index
+      uint32_t file_offset;
+      uint32_t size;             // In the file
+      uint32_t raw_size;         // Decompressed
+    };
+
+    // Sorted by left, then right code point
+
+    struct Kerning {
+      uint32_t left, right;
+      int8_t   value;
+      uint8_t  reserved[3];
+    };
+
+    FontFile(uint32_t cache_size = DEFAULT_CACHE_SIZE) : file(nullptr), file_size(0), cache_size(cache_size),
+      cached_size(0), hits(0), misses(0) {}
+    ~FontFile() { close(); }
+
+    /**
+     * @brief Open a font file and load its index
+     *
+     * @return false if the file is missing or not a valid font file.
+     */
+    bool  open(const char * filename);
+    void close();
+
+    bool   getGlyph(uint32_t codepoint, FontGlyph & glyph) override;
+    bool getMetrics(uint32_t codepoint, FontGlyph & glyph) override;
+    int8_t getKerning(uint32_t left, uint32_t right) override;
+    uint8_t getYAdvance() override { return header.y_advance; }
+    uint32_t getIdentity() override;
+
+    inline bool          isOpen() const { return file != nullptr; }
+    inline uint32_t getGlyphCount() const { return header.glyph_count; }
+    inline uint32_t        getHits() const { return hits;   }
+    inline uint32_t      getMisses() const { return misses; }
+    inline void      resetCounters()       { hits = misses = 0; }
+
+    void setCacheSize(uint32_t bytes);
+
+  private:
+    static constexpr char const * TAG = "FontFile";
+
+    // Glyph offsets are 16 bits and a glyph bitmap is at most 255 rows of
+    // 128 bytes: a larger page is a corrupted one
+
+    static constexpr uint32_t MAX_PAGE_SIZE = 0x10000 + 255 * 128;
+
+    struct CachedPage {
+      uint16_t             index;
+      std::vector<uint8_t> data;
+    };
+
+    FILE *                 file;
+    long                   file_size;
+    Header                 header;
+    std::vector<Range>     ranges;
+    std::vector<Glyph>     glyphs;
+    std::vector<Page>      pages;
+    std::vector<Kerning>   kernings;
+    std::list<CachedPage>  cache;        // Most recently used first
+    uint32_t               cache_size;
+    uint32_t               cached_size;
+    uint32_t               hits, misses;
+
+    bool              validIndex() const;
+    int32_t           glyphIndex(uint32_t codepoint) const;
+    void              setMetrics(const Glyph & g, FontGlyph & glyph) const;
+    const uint8_t * getPage(uint16_t index);
+    void                 trim(uint32_t needed);
+};
+
+static_assert(sizeof(FontFile::Header) == 20, "Unexpected font file header layout");
+static_assert(sizeof(FontFile::Range)  ==  8, "Unexpected font file range layout");
+static_assert(sizeof(FontFile::Glyph)  ==  8, "Unexpected font file glyph layout");
+static_assert(sizeof(FontFile::Page)   == 16, "Unexpected font file page layout");
+static_assert(sizeof(FontFile::Kerning) == 12, "Unexpected font file kerning layout");
+
+#endif
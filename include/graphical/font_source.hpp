@@ -0,0 +1,142 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __FONT_SOURCE_HPP__
+#define __FONT_SOURCE_HPP__
+
+#include <cinttypes>
+#include <unordered_map>
+
+#include "gray_font.hpp"
+
+/**
+ * @brief A glyph, as supplied by a FontSource
+ *
+ * The bitmap holds the coverage of each pixel on bpp bits (1, 2 or 4), most
+ * significant bits first. Rows are stride_bits apart: GFXfont glyphs are a
+ * continuous stream of bits, other formats start each row on a byte
+ * boundary. Offsets are from the cursor position (on the baseline) to the
+ * top left corner of the bitmap.
+ */
+struct FontGlyph
+{
+  const uint8_t * bitmap;
+  uint16_t        stride_bits;
+  uint8_t         bpp;
+  uint16_t        width, height;
+  uint16_t        x_advance;
+  int16_t         x_offset, y_offset;
+};
+
+/**
+ * @brief Glyphs retrieval by Unicode code point
+ *
+ * Used by Graphics::setFontSource() and TextLayout to render UTF-8 text with
+ * fonts that are not limited to 8 bits character codes. Advances are kept in
+ * a table filled as code points are measured, such that text layout doesn't
+ * retrieve the glyphs again.
+ */
+class FontSource
+{
+  public:
+    FontSource() : low_advances_ready(false) {}
+    virtual ~FontSource() {}
+
+    /**
+     * @brief Retrieve a glyph
+     *
+     * The glyph bitmap may only be valid until the next call.
+     *
+     * @return false if the font has no glyph for this code point.
+     */
+    virtual bool getGlyph(uint32_t codepoint, FontGlyph & glyph) = 0;
+
+    /**
+     * @brief Retrieve the metrics of a glyph, without its bitmap
+     *
+     * To be overridden by sources for which the bitmaps are costly to get.
+     */
+    virtual bool getMetrics(uint32_t codepoint, FontGlyph & glyph) { return getGlyph(codepoint, glyph); }
+
+    /**
+     * @brief Horizontal adjustment between two characters, in pixels
+     */
+    virtual int8_t getKerning(uint32_t /* left */, uint32_t /* right */) { return 0; }
+
+    /**
+     * @brief Distance between lines, in pixels
+     */
+    virtual uint8_t getYAdvance() = 0;
+
+    /**
+     * @brief Value identifying the font
+     *
+     * Changes when the font does in ways its metrics may not show: glyphs
+     * added or removed, kerning, file replaced. Used to detect stale page
+     * indexes.
+     */
+    virtual uint32_t getIdentity() { return 0; }
+
+    /**
+     * @brief Cursor advance of a code point, from the advance table
+     *
+     * @return -1 if the font has no glyph for this code point.
+     */
+    int16_t getAdvance(uint32_t codepoint);
+
+  protected:
+    // To be called when the font changes (e.g. a file being reopened)
+
+    void clearAdvances() { low_advances_ready = false; high_advances.clear(); }
+
+    // Adds the 4 bytes of a value to an FNV-1a hash, for getIdentity()
+
+    static void mixIdentity(uint32_t & hash, uint32_t value);
+
+  private:
+    // Code points below 256 are in a flat table, built at the first call
+
+    static constexpr uint16_t LOW_COUNT = 256;
+
+    bool                                  low_advances_ready;
+    int16_t                               low_advances[LOW_COUNT];
+    std::unordered_map<uint32_t, int16_t> high_advances;
+};
+
+/**
+ * @brief A compiled in GFXfont or GrayFont as a FontSource
+ */
+class GFXFontSource : public FontSource
+{
+  public:
+    GFXFontSource(const GFXfont  * font) : font(font),       bpp(1) {}
+    GFXFontSource(const GrayFont * font) : font(&font->font), bpp(font->bpp) {}
+
+    bool getGlyph(uint32_t codepoint, FontGlyph & glyph) override {
+      if ((codepoint < font->first) || (codepoint > font->last)) return false;
+
+      const GFXglyph * g = &font->glyph[codepoint - font->first];
+
+      glyph.bitmap      = &font->bitmap[g->bitmapOffset];
+      glyph.bpp         = bpp;
+      glyph.stride_bits = (bpp == 1) ? g->width : ((g->width * bpp + 7) & ~7);
+      glyph.width       = g->width;
+      glyph.height      = g->height;
+      glyph.x_advance   = g->xAdvance;
+      glyph.x_offset    = g->xOffset;
+      glyph.y_offset    = g->yOffset;
+
+      return true;
+    }
+
+    uint8_t getYAdvance() override { return font->yAdvance; }
+
+    uint32_t getIdentity() override;
+
+  private:
+    const GFXfont * font;
+    uint8_t         bpp;
+};
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __GLYPH_CACHE_HPP__
+#define __GLYPH_CACHE_HPP__
+
+#include <cinttypes>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "gfx_font.hpp"
+
+/**
+ * @brief Least recently used cache of rasterized glyphs
+ *
+ * An entry is the mask of a custom font glyph, scaled, rotated and shifted to
+ * its position in the frame buffer bytes: one bit per pixel, least
+ * significant bit first, for the 1-bit frame buffer, and one nibble per pixel
+ * (0xF when set), high nibble first, for the 3-bit frame buffer. The rows of
+ * an entry can then be combined with the frame buffer a byte (or a word) at
+ * a time, whatever the color.
+ *
+ * Entries are identified by the font, the character, the scaling factors,
+ * the rotation, the frame buffer format and the position of the first pixel
+ * in the first byte (0 to 7 in 1-bit mode, 0 or 1 in 3-bit mode). The least
+ * recently used ones are removed when the cache is over its capacity. A
+ * capacity of 0 disables the cache.
+ */
+class GlyphCache
+{
+  public:
+    static constexpr uint32_t DEFAULT_CAPACITY = 16 * 1024; // Bytes
+
+    struct Key {
+      const GFXfont * font;
+      uint8_t         c;
+      uint8_t         size_x, size_y;
+      uint8_t         rotation;
+      uint8_t         offset;
+      bool            three_bit;
+
+      bool operator==(const Key & other) const {
+        return (font     == other.font    ) && (c      == other.c     ) &&
+               (size_x   == other.size_x  ) && (size_y == other.size_y) &&
+               (rotation == other.rotation) && (offset == other.offset) &&
+               (three_bit == other.three_bit);
+      }
+    };
+
+    struct Entry {
+      Key                  key;
+      int16_t              stride;  // Bytes per row
+      int16_t              rows;
+      std::vector<uint8_t> data;
+    };
+
+    GlyphCache(uint32_t capacity = DEFAULT_CAPACITY) : capacity(capacity), size(0), hits(0), misses(0) {}
+
+    /**
+     * @brief Retrieve an entry
+     *
+     * The entry becomes the most recently used one. Hits and misses are
+     * counted.
+     *
+     * @return The entry, or nullptr if not in the cache.
+     */
+    const Entry * find(const Key & key);
+
+    /**
+     * @brief Add an entry
+     *
+     * Least recently used entries are removed to make room for it. Entries
+     * larger than a quarter of the capacity are not kept.
+     *
+     * @return The entry as kept in the cache, or nullptr if not kept.
+     */
+    const Entry * insert(Entry && entry);
+
+    /**
+     * @brief An entry with data_size bytes of mask would be kept by insert()
+     */
+    inline bool accepts(uint32_t data_size) const {
+      return (capacity > 0) && (data_size + sizeof(Entry) + 32 <= (capacity >> 2));
+    }
+
+    void  setCapacity(uint32_t bytes);
+    void        clear();
+
+    inline uint32_t getCapacity() const { return capacity; }
+    inline uint32_t     getSize() const { return size;     }
+    inline uint32_t    getCount() const { return entries.size(); }
+    inline uint32_t     getHits() const { return hits;     }
+    inline uint32_t   getMisses() const { return misses;   }
+    inline void   resetCounters()       { hits = misses = 0; }
+
+    /**
+     * @brief Ratio of hits over lookups since the last counters reset
+     */
+    float getHitRate() const { return (hits + misses) ? (float) hits / (hits + misses) : 0.0f; }
+
+  private:
+    struct KeyHash {
+      size_t operator()(const Key & key) const {
+        return (size_t) key.font ^ (((size_t) key.c << 16) | (key.size_x << 12) | (key.size_y << 8) |
+                                    (key.rotation << 5) | (key.offset << 1) | key.three_bit);
+      }
+    };
+
+    typedef std::list<Entry> Entries;
+
+    // Bytes accounted for an entry, including its bookkeeping
+
+    static uint32_t entrySize(const Entry & entry) { return entry.data.size() + sizeof(Entry) + 32; }
+
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t hits, misses;
+    Entries  entries;    // Most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+
+    void evict(uint32_t needed);
+};
+
+#endif
@@ -20,6 +20,9 @@ Distributed as-is; no warranty is given.
 #include "image.hpp"
 #include "shapes.hpp"
 #include "frame_buffer.hpp"
+#include "pixel_sink.hpp"
+#include "glyph_cache.hpp"
+#include "font_source.hpp"
 
 #ifndef pgm_read_byte
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
@@ -37,6 +40,37 @@ Distributed as-is; no warranty is given.
 #define pgm_read_pointer(addr) ((void *)pgm_read_word(addr))
 #endif
 
+/**
+ * @brief A rectangle of a frame buffer, saved by Graphics::saveRegion()
+ *
+ * Frame buffer bytes are kept as is, possibly PackBits compressed. The
+ * pixels of the first and last bytes of each row that are outside of the
+ * rectangle are not restored.
+ */
+class SavedRegion
+{
+  public:
+    ~SavedRegion() { delete [] data; }
+
+    inline const Rect &    getRect() const { return rect;      }
+    inline uint32_t        getSize() const { return data_size; }
+    inline bool     isCompressed() const { return compressed; }
+
+  private:
+    friend class Graphics;
+
+    SavedRegion() : data(nullptr) {}
+
+    DisplayMode mode;
+    Rect        rect;           // Logical, at the time it was saved
+    int16_t     x, y, w, h;     // Physical, in pixels
+    int16_t     first_byte;     // Of each row
+    int16_t     row_bytes;
+    bool        compressed;
+    uint8_t   * data;
+    uint32_t    data_size;
+};
+
 class Graphics : public Shapes, public Image
 {
   private:
@@ -59,10 +93,176 @@ class Graphics : public Shapes, public Image
     void               display();
     void         preloadScreen();
     void         partialUpdate(bool _forced = false);
+    void         partialUpdate(const Rect & region, bool _forced = false);
 
     int16_t  width() override;
     int16_t height() override;
 
+    void      fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void    fillScreen(uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+
+    using Adafruit_GFX::drawChar;
+
+    void       drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) override;
+    void drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color) override;
+    void       drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) override;
+    void       drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg) override;
+    void         drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y) override;
+
+    using Adafruit_GFX::drawBitmap;
+
+    // Custom font glyphs are drawn from a cache of bitmaps already in the
+    // frame buffer orientation and pixel format (see glyph_cache.hpp). Its
+    // capacity and hit counters are available through getGlyphCache().
+
+    GlyphCache & getGlyphCache() { return glyph_cache; }
+
+    // Anti-aliased fonts (see gray_font.hpp). setGrayFont() selects the font
+    // metrics with setFont() and draws the glyphs with their coverage: in
+    // 3-bit mode, the text color is blended with the gray level already in
+    // the frame buffer; in 1-bit mode, pixels covered at least by half get
+    // the text color. Calling setFont() afterward selects a regular font.
+
+    void setGrayFont(const GrayFont * font);
+
+    // Fonts from a FontSource (e.g. a FontFile on the SD card, see
+    // font_file.hpp). Once selected, text written with print() and write()
+    // is decoded as UTF-8 and drawn with the source glyphs, the cursor being
+    // on the baseline. setFontSource(nullptr) goes back to the Adafruit_GFX
+    // fonts. drawGlyph() draws a single glyph with its coverage, as
+    // described for setGrayFont().
+
+    void setFontSource(FontSource * source);
+    void     drawGlyph(int16_t x, int16_t y, const FontGlyph & glyph, uint16_t color,
+                       uint8_t size_x = 1, uint8_t size_y = 1);
+
+    using Adafruit_GFX::write;
+    size_t write(uint8_t c) override;
+
+    // Text magnification. setTextSize() gives integer factors, as with
+    // Adafruit_GFX. setTextScale() also accepts fractional ones, for custom
+    // fonts and font sources: glyph pixels are expanded to the screen pixels
+    // they cover (nearest neighbor). Scaled glyphs are drawn as rectangles,
+    // one for each run of set pixels of a glyph row, as high as the screen
+    // rows covered by this row and the identical ones following it.
+
+    void  setTextSize(uint8_t s);
+    void  setTextSize(uint8_t s_x, uint8_t s_y);
+    void setTextScale(float s);
+    void setTextScale(float s_x, float s_y);
+
+    // Text settings: font, font source, size, wrap, colors and cursor.
+    // Code drawing text for others (e.g. DisplayList) takes them with
+    // getTextState() and puts them back with setTextState().
+
+    struct TextState {
+        const GFXfont *  font;
+        const GrayFont * grayFont;
+        FontSource *     fontSource;
+        uint8_t          size_x, size_y;
+        uint16_t         scale_x, scale_y;
+        bool             wrap;
+        uint16_t         color, bg;
+        int16_t          cursor_x, cursor_y;
+    };
+
+    TextState getTextState() const;
+    void      setTextState(const TextState & state);
+
+    // Blit engine (graphics_blit.cpp). Combines a rectangle of a 1-bit
+    // bitmap with the screen using a raster operation (see RasterOp in
+    // defines.hpp). Bitmap rows are stride bytes long, most significant bit
+    // first (the Adafruit_GFX format) unless lsb_first is true (the 1-bit
+    // frame buffer format). In 3-bit mode, a set bit is black.
+
+    void blit(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h,
+              RasterOp op = RasterOp::COPY, bool lsb_first = false);
+    void blit(int16_t x, int16_t y, const uint8_t * bitmap, int16_t stride, int16_t src_x, int16_t src_y, int16_t w, int16_t h,
+              RasterOp op = RasterOp::COPY, bool lsb_first = false);
+
+    // Offscreen canvases (graphics_canvas.cpp). A canvas is drawn with its
+    // top left corner at (x, y), clipped as everything else. A GFXcanvas1 is
+    // combined with the screen using a raster operation, as with blit().
+    // GFXcanvas8 values are display colors (0 to 7 in 3-bit mode, 0 or 1 in
+    // 1-bit mode) and GFXcanvas16 values are RGB565 colors converted to gray
+    // levels. Pixels equal to transparent are left untouched, unless it is
+    // negative.
+
+    void drawCanvas(int16_t x, int16_t y, const GFXcanvas1  & canvas, RasterOp op = RasterOp::COPY);
+    void drawCanvas(int16_t x, int16_t y, const GFXcanvas8  & canvas, int16_t transparent = -1);
+    void drawCanvas(int16_t x, int16_t y, const GFXcanvas16 & canvas, int32_t transparent = -1);
+
+    // Clipping. All drawing is limited to the clipping rectangle, initially
+    // the whole screen. pushClipRect() intersects it with a rectangle, up to
+    // CLIP_STACK_SIZE levels deep, and popClipRect() goes back to the
+    // previous one. Rectangles are in logical coordinates: setRotation()
+    // resets the clipping to the whole screen.
+
+    static constexpr int8_t CLIP_STACK_SIZE = 8;
+
+    bool  pushClipRect(int16_t x, int16_t y, int16_t w, int16_t h);
+    bool  pushClipRect(const Rect & rect) { return pushClipRect(rect.x, rect.y, rect.w, rect.h); }
+    bool   popClipRect();
+    void resetClipRect();
+    Rect   getClipRect() override;
+
+    // Region save and restore (graphics_region.cpp), for overlays such as
+    // menus. saveRegion() copies a rectangle of the current frame buffer,
+    // clipped to the screen, and returns nullptr if it is empty. The caller
+    // owns the returned region. restoreRegion() puts it back in place, if
+    // the display mode is the same, and returns the restored rectangle (to
+    // be refreshed, e.g. with partialUpdate()), empty otherwise.
+
+    SavedRegion *  saveRegion(int16_t x, int16_t y, int16_t w, int16_t h, bool compress = false);
+    Rect        restoreRegion(const SavedRegion & region);
+
+    // Scrolling (graphics_scroll.cpp). The content of a rectangle, limited
+    // to the clipping rectangle, is moved in place by dy rows (down when
+    // positive) or by dx columns (right when positive). The pixels moved
+    // out are lost and the revealed strip keeps its previous content: it
+    // is returned, to be redrawn by the application. The whole rectangle
+    // has to be refreshed on the panel.
+
+    Rect       scrollRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dy);
+    Rect        shiftRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx);
+
+    // Pattern fills (graphics_pattern.cpp). A pattern is 8 bytes, one per
+    // row, pixel 0 of a row being the least significant bit. Pixels whose
+    // pattern bit is set get the color, the others get bg, or are left
+    // untouched if bg is negative. The pattern is anchored to the frame
+    // buffer (physical) coordinates, such that adjacent fills join seamlessly.
+
+    static void bayerPattern(uint8_t level, uint8_t pattern[8]);
+
+    void    fillRectPattern(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t pattern[8], uint16_t color, int16_t bg = -1);
+    void  fillCirclePattern(int16_t x0, int16_t y0, int16_t r, const uint8_t pattern[8], uint16_t color, int16_t bg = -1);
+    void fillPolygonPattern(int *x, int *y, int n, const uint8_t pattern[8], uint16_t color, int16_t bg = -1);
+    void   fillGradientRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t level0, uint8_t level1, bool vertical,
+                            uint16_t color, uint16_t bg);
+
+    /**
+     * @brief Run a drawing function with a direct frame buffer writer
+     *
+     * The PixelSink matching the current display mode and rotation is
+     * selected once, and handed to the function. The function is expected
+     * to be a generic lambda (auto parameter) so that it gets compiled for
+     * every mode/rotation combination:
+     *
+     *   display.withPixelSink([&](auto & sink) {
+     *     for (...) sink.drawPixel(x, y, color);
+     *   });
+     */
+    template <typename F>
+    void withPixelSink(F && f)
+    {
+        if (display_mode == DisplayMode::INKPLATE_1BIT)
+            withPixelSinkMode<DisplayMode::INKPLATE_1BIT>(_partial, f);
+        else
+            withPixelSinkMode<DisplayMode::INKPLATE_3BIT>(DMemory4Bit, f);
+    }
+
     FrameBuffer1Bit *_partial;
     FrameBuffer3Bit * DMemory4Bit;
 
@@ -82,6 +282,91 @@ class Graphics : public Shapes, public Image
     void writeFastHLine(int16_t  x, int16_t  y, int16_t  w,  uint16_t color) override;
     void      writeLine(int16_t x0, int16_t y0, int16_t  x1, int16_t  y1, uint16_t color) override;
     void       endWrite(void) override;
+
+    void    writePixelRow(int16_t x, int16_t y, const uint8_t * colors, int16_t count) override;
+    void  writePixelBlock(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * colors) override;
+    void   writeNibbleRow(int16_t x, int16_t y, const uint8_t * src, int16_t w) override;
+
+    void      blitRotated(int16_t x, int16_t y, const uint8_t * src, int16_t stride, int16_t src_x, int16_t w, int16_t h,
+                          RasterOp op, bool lsb_first);
+
+    template <DisplayMode MODE, typename F>
+    void withPixelSinkMode(FrameBuffer * frame_buffer, F & f)
+    {
+        uint8_t * data      = frame_buffer->get_data();
+        int16_t   line_size = frame_buffer->get_line_size();
+
+        switch (rotation) {
+          case 1:  { PixelSink<MODE, 1> sink(data, line_size, WIDTH, HEIGHT); runWithClip(sink, f); break; }
+          case 2:  { PixelSink<MODE, 2> sink(data, line_size, WIDTH, HEIGHT); runWithClip(sink, f); break; }
+          case 3:  { PixelSink<MODE, 3> sink(data, line_size, WIDTH, HEIGHT); runWithClip(sink, f); break; }
+          default: { PixelSink<MODE, 0> sink(data, line_size, WIDTH, HEIGHT); runWithClip(sink, f); break; }
+        }
+    }
+
+    template <typename S, typename F>
+    void runWithClip(S & sink, F & f)
+    {
+        sink.setClip(clip_x0, clip_y0, clip_x1, clip_y1);
+        f(sink);
+    }
+
+    // Clipping rectangle (inclusive bounds) and the saved ones
+
+    int16_t clip_x0, clip_y0, clip_x1, clip_y1;
+    Rect    clip_stack[CLIP_STACK_SIZE];
+    int8_t  clip_depth = 0;
+
+    bool clipRect(int16_t & x, int16_t & y, int16_t & w, int16_t & h, int16_t & dx, int16_t & dy);
+
+    // Span kernels (graphics_span.cpp)
+
+    const uint8_t * fill_pattern = nullptr; // Current pattern for the span kernels, if any
+    int16_t         fill_pattern_bg;
+
+    bool              toPhysicalRect(int16_t & x, int16_t & y, int16_t & w, int16_t & h);
+    void           logicalToPhysical(int16_t & x, int16_t & y, int16_t & w, int16_t & h);
+    void        fillPhysicalRect1Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void        fillPhysicalRect3Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillPhysicalRectPattern1Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillPhysicalRectPattern3Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    // Scrolling kernel (graphics_scroll.cpp)
+
+    Rect moveRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx, int16_t dy);
+
+    // Cached glyphs (graphics_text.cpp)
+
+    GlyphCache glyph_cache;
+
+    const GlyphCache::Entry * getCachedGlyph(const GFXglyph * glyph, const uint8_t * bitmap, unsigned char c,
+                                             int16_t w, int16_t h, uint8_t size_x, uint8_t size_y, uint8_t offset);
+    void                        drawCachedGlyph(const GlyphCache::Entry & entry, int16_t x, int16_t y, uint16_t color);
+
+    // Anti-aliased glyphs (graphics_text.cpp). The blending table gives the
+    // level of a pixel from its coverage (on 4 bits) and its current level,
+    // for gray_lut_color.
+
+    const GrayFont * grayFont       = nullptr;
+    int16_t          gray_lut_color = -1;
+    uint8_t          gray_lut[16][8];
+
+    // Font source and UTF-8 decoding state
+
+    FontSource * fontSource     = nullptr;
+    uint32_t     utf8_codepoint = 0;
+    uint8_t      utf8_remaining = 0;
+
+    void writeCodepoint(uint32_t codepoint);
+
+    // Fractional text scale, 8.8 fixed point. 0 when set by setTextSize().
+
+    uint16_t text_scale_x = 0;
+    uint16_t text_scale_y = 0;
+
+    bool     getGFXGlyph(uint32_t c, FontGlyph & glyph);
+    void drawScaledGlyph(int16_t x, int16_t y, const FontGlyph & glyph, uint16_t color,
+                         uint16_t scale_x, uint16_t scale_y);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __GRAY_FONT_HPP__
+#define __GRAY_FONT_HPP__
+
+#include <cinttypes>
+
+#include "gfx_font.hpp"
+
+/**
+ * @brief Anti-aliased font
+ *
+ * The glyph metrics are the ones of a GFXfont, such that the Adafruit_GFX
+ * text methods (cursor advance, wrapping, getTextBounds()) work unchanged.
+ * The bitmap holds the coverage of each pixel on bpp bits (2 or 4), from 0
+ * (not covered) to 3 or 15 (fully covered), most significant bits first.
+ * Each glyph row starts on a byte boundary.
+ *
+ * Such fonts are generated from TrueType or OpenType fonts with the
+ * tools/gray_font_convert utility, and selected with Graphics::setGrayFont().
+ */
+typedef struct
+{
+	GFXfont  font;         ///< Metrics, the bitmap being the pixels coverage
+	uint8_t  bpp;          ///< Bits per pixel: 2 or 4
+} GrayFont;
+
+#endif // __GRAY_FONT_HPP__
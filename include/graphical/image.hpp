@@ -22,6 +22,7 @@ Distributed as-is; no warranty is given.
 
 #include "defines.hpp"
 #include "adafruit_gfx.hpp"
+#include "image_resampler.hpp"
 
 class Image : virtual public Adafruit_GFX
 {
@@ -56,6 +57,17 @@ class Image : virtual public Adafruit_GFX
         TopRight,
         BottomRight
     } Position;
+
+    typedef enum
+    {
+        NoScaling,   // Drawn as is, cropped to the box
+        ScaleToFit,  // Scaled to fit in the box, whole
+        ScaleToFill  // Scaled to cover the box, cropped
+    } Scaling;
+
+    // Image data input: returns the number of bytes read (less than len at
+    // the end), or -1 on error
+    typedef int32_t (*ImageReader)(void *context, uint8_t *buf, uint32_t len);
 	
     Image(int16_t w, int16_t h);
 
@@ -63,6 +75,7 @@ class Image : virtual public Adafruit_GFX
 
     virtual void        selectDisplayMode(DisplayMode _mode) = 0;
     virtual DisplayMode getDisplayMode() = 0;
+    virtual Rect           getClipRect() = 0;
     virtual int16_t     width()  = 0;
     virtual int16_t     height() = 0;
 
@@ -73,6 +86,12 @@ class Image : virtual public Adafruit_GFX
     bool drawImage(const std::string path, const Format& format, const int x, const int y, const bool dither = 1, const bool invert = 0);
     bool drawImage(const char* path, const Format& format, const Position& position, const bool dither = 1, const bool invert = 0);	
 
+    // The image is placed in the box according to the position, after being
+    // scaled (area averaging) if requested. Decoded rows are resampled as
+    // they come: the image is never kept whole in memory.
+    bool drawImage(const char *path, const Format &format, const Rect &box, const Scaling &scaling,
+                   const Position &position = Center, const bool dither = 1, const bool invert = 0);
+
     bool drawBitmapFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
     bool   drawJpegFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
     bool    drawPngFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
@@ -85,6 +104,14 @@ class Image : virtual public Adafruit_GFX
     bool    drawJpegFromWeb(const char *url, int x, int y, bool dither = 0, bool invert = 0);
     bool     drawPngFromWeb(const char *url, int x, int y, bool dither = 0, bool invert = 0);
 
+    // JPEG images larger than the box are reduced to fit in it, keeping their
+    // aspect ratio, mostly by the decoder (1/2, 1/4 or 1/8 scaling). They are
+    // centered in the box, and never enlarged.
+
+    bool drawJpegFromFile(const char *fileName, const Rect &box, bool dither = 0, bool invert = 0);
+    bool drawJpegFromFile(FILE *p, const Rect &box, bool dither = 0, bool invert = 0);
+    bool  drawJpegFromWeb(const char *url, const Rect &box, bool dither = 0, bool invert = 0);
+
     // Defined in Adafruit-GFX-Library, but should fit here
     // void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
     // void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color,
@@ -99,6 +126,8 @@ class Image : virtual public Adafruit_GFX
     // Should be private, but needed in a png callback :(
     void           ditherSwap(int w);
     uint8_t ditherGetPixelBmp(uint8_t px, int i, int w, bool paletted);
+    void          bufferPixel(int16_t x, int16_t y, uint8_t color);
+    void        flushPixelRow();
 
     static inline int16_t rowSize(int16_t w, int8_t c) { return ((c * w + 31) >> 5) << 2; }
 
@@ -120,6 +149,9 @@ class Image : virtual public Adafruit_GFX
     virtual void writeFastHLine(int16_t  x, int16_t  y, int16_t  w, uint16_t color) = 0;
     virtual void      writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t  y1, uint16_t color) = 0;
     virtual void       endWrite(void) = 0;
+    virtual void  writePixelRow(int16_t  x, int16_t  y, const uint8_t * colors, int16_t count) = 0;
+    virtual void writePixelBlock(int16_t x, int16_t  y, int16_t  w, int16_t  h, const uint8_t * colors) = 0;
+    virtual void writeNibbleRow(int16_t  x, int16_t  y, const uint8_t * src, int16_t w) = 0;
 
     static bool   drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap, bool dither, bool invert);
 
@@ -132,10 +164,39 @@ class Image : virtual public Adafruit_GFX
     int16_t ditherBufferSize;
     int16_t pixelBufferSize;
 
+    // Decoded pixels are gathered in rows, sent to writePixelRow() at once.
+    // JPEG blocks that fit are sent whole to writePixelBlock().
+
+    uint8_t * rowBuffer;    //[e_ink_width]
+    int16_t rowBufferSize;
+    int16_t rowCount = 0;
+    int16_t rowX, rowY;
+
     uint8_t jpegDitherBuffer[18][18];
     int16_t blockW = 0, blockH = 0;
     int16_t lastY = -1;
 
+    // Images drawn in a box: the decoded rows go through the resampler, as
+    // gray levels, then to the dithering (see image_box.cpp)
+
+    struct BoxSettings
+    {
+        Rect     box;
+        Scaling  scaling;
+        Position position;
+        bool     enlarge, dither, invert;
+    } boxSettings;
+
+    ImageResampler * resampler = nullptr;
+    uint8_t * resampleRows = nullptr; // Decoded rows, as gray levels
+    int16_t resampleRowCount;         // Rows in resampleRows
+    int16_t resampleSrcWidth;         // Decoded width
+    int16_t resampleX;                // Screen column of the visible window
+    int16_t resampleWidth;            // Visible window width
+    int16_t resampleY;                // Screen row of the scaled image top
+    int16_t resampleHeight;           // Scaled image height
+    bool    resampleFlip;             // Bottom-up rows
+
     uint8_t ditherPalette[256]; // 8 bit colors
     uint8_t palette[128];       // 2 3 bit colors per byte, _###_###
 
@@ -144,16 +205,28 @@ class Image : virtual public Adafruit_GFX
     uint8_t ditherGetPixelJpeg(uint8_t px, int i, int j, int x, int y, int w, int h);
     void ditherSwapBlockJpeg(int x);
 
+    static int32_t readFile(void *context, uint8_t *buf, uint32_t len);
+    static int32_t  readWeb(void *context, uint8_t *buf, uint32_t len);
+
+    void     scaledSize(uint16_t w, uint16_t h, int16_t &tw, int16_t &th);
+    bool startResampling(int16_t w, int16_t h, int16_t tw, int16_t th, int16_t rows, bool flip);
+    void  stopResampling();
+    static void drawResampledRow(void *context, int16_t row, const uint8_t *gray);
+
+    bool drawBitmapInBox(const char *url, FILE *p);
+    bool   drawJpegInBox(const char *url, FILE *p);
+    bool    drawPngInBox(const char *url, FILE *p);
+
     void readBmpHeader(uint8_t *buf, bitmapHeader *_h);
     void readBmpHeaderFromFile(FILE *_f, bitmapHeader *_h);
+    bool readBmpHeaderFromStream(ImageReader reader, void *context, bitmapHeader *_h);
+    void bmpLineToGray(bitmapHeader *bmpHeader, uint8_t *gray);
 
     inline void displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool dither, bool invert);
 
     void getPointsForPosition(const Position& position, const uint16_t imageWidth, const uint16_t imageHeight, 
 		const uint16_t screenWidth, const uint16_t screenHeight, uint16_t *posX, uint16_t *posY);
 
-    bool drawJpegFromWebAtPosition(const char* url, const Position& position, const bool dither = 0, const bool invert = 0);
-
     // FUTURE COMPATIBILITY FUNCTIONS; DO NOT USE!
 
     void drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
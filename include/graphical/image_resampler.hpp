@@ -0,0 +1,68 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __IMAGE_RESAMPLER_HPP__
+#define __IMAGE_RESAMPLER_HPP__
+
+#include <cinttypes>
+
+#include "defines.hpp"
+
+/**
+ * @brief Streaming area averaging (box filter) image resampler
+ *
+ * Rows of gray levels are pushed as decoded, in order. Each output pixel is
+ * the average of the source pixels it covers, weighted by the covered area,
+ * for reductions as well as enlargements. An output row is sent to the
+ * output function as soon as all the source rows it covers have been
+ * pushed: only two rows of the output width are kept.
+ *
+ * Only a window of the output image is computed (the part that is visible
+ * on screen): source rows outside of it cost nothing more than the call.
+ */
+class ImageResampler
+{
+  public:
+    /**
+     * @brief Output row function
+     *
+     * @param context As given to the constructor
+     * @param row Output row, from the top of the output image
+     * @param gray window.w gray levels, from column window.x
+     */
+    typedef void (*RowOutput)(void * context, int16_t row, const uint8_t * gray);
+
+    ImageResampler(int16_t src_width, int16_t src_height,
+                   int16_t dst_width, int16_t dst_height,
+                   const Rect & window, RowOutput output, void * context);
+   ~ImageResampler();
+
+    /**
+     * @brief The buffers have been allocated
+     */
+    inline bool isReady() const { return row_sums != nullptr; }
+
+    /**
+     * @brief Push the next source row
+     *
+     * @param gray src_width gray levels
+     */
+    void pushRow(const uint8_t * gray);
+
+    inline bool isComplete() const { return src_row >= src_height; }
+
+  private:
+    int16_t   src_width, src_height;
+    int16_t   dst_width, dst_height;
+    Rect      window;
+    RowOutput output;
+    void    * context;
+    int16_t   src_row;
+
+    uint16_t * row_sums;   // Current row, horizontally resampled, 8.8 fixed point
+    uint32_t * sums;       // Output row being accumulated
+    uint8_t  * out;
+};
+
+#endif
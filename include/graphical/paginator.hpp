@@ -0,0 +1,140 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __PAGINATOR_HPP__
+#define __PAGINATOR_HPP__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "text_layout.hpp"
+
+/**
+ * @brief Pages of a long UTF-8 text file
+ *
+ * The text is split in pages of the lines fitting in a width and height,
+ * laid out with a TextLayout. The byte offset where each page starts is kept
+ * in an index file, next to the text file (its name with ".idx" appended),
+ * such that drawing a page costs a seek and the layout of this page only.
+ *
+ *   GFXFontSource font(&FreeSerif12pt7b);
+ *   Paginator     book(font, 560, 760, TextLayout::Align::JUSTIFY);
+ *
+ *   if (book.open("/sdcard/books/story.txt")) {
+ *     book.startIndexing();
+ *     book.drawPage(display, page, 20, 40, BLACK);
+ *   }
+ *
+ * The index is built incrementally: buildIndex() adds a given count of
+ * pages, and startIndexing() completes it in a background task. A page not
+ * indexed yet is located when drawn. The index is kept when the file is
+ * opened again with the same font metrics and page size. If the file grew
+ * since (a log file), indexing resumes at its last page: the text is
+ * expected to be appended to, not modified.
+ */
+class Paginator
+{
+  public:
+    static constexpr char    MAGIC[4] = { 'I', 'P', 'I', 'X' };
+    static constexpr uint8_t VERSION  = 1;
+
+    struct Header {
+      char     magic[4];
+      uint8_t  version;
+      uint8_t  complete;         // All pages are indexed
+      uint16_t lines_per_page;
+      uint32_t signature;        // Font metrics and page size
+      uint32_t text_size;        // Bytes indexed
+      uint32_t page_count;       // Page offsets following the header
+    };
+
+    /**
+     * @param width  Width of the text area, in pixels.
+     * @param height Height of the text area, in pixels.
+     */
+    Paginator(FontSource & font, int16_t width, int16_t height,
+              TextLayout::Align align = TextLayout::Align::LEFT);
+   ~Paginator();
+
+    /**
+     * @brief Open a text file
+     *
+     * Its index file is loaded if it matches the font and the page size.
+     *
+     * @return false if the file cannot be read.
+     */
+    bool open(const char * filename);
+    void close();
+
+    /**
+     * @brief Add pages to the index
+     *
+     * @param count Count of pages to add, 0 for all.
+     * @return true if the index is complete.
+     */
+    bool buildIndex(uint32_t count = 0);
+
+    /**
+     * @brief Complete the index in a background task
+     *
+     * @return false if the task cannot be created.
+     */
+    bool startIndexing(UBaseType_t priority = 1);
+
+    /**
+     * @brief Draw a page
+     *
+     * @param x Left side of the text area.
+     * @param y Baseline of the first line.
+     * @return false if the page doesn't exist.
+     */
+    bool drawPage(Graphics & graphics, uint32_t page, int16_t x, int16_t y, uint16_t color);
+
+    /**
+     * @brief Count of pages indexed so far
+     */
+    uint32_t getPageCount();
+    bool       isComplete();
+
+    inline TextLayout & getLayout() { return layout; }
+
+  private:
+    static constexpr char const * TAG = "Paginator";
+
+    static constexpr uint32_t CHUNK_SIZE     = 4096; // First read of a page, doubled as needed
+    static constexpr uint32_t PAGES_PER_STEP = 8;    // Indexed by the background task between yields
+
+    FontSource &          font;
+    int16_t               width, height;
+    TextLayout            layout;
+    uint16_t              lines_per_page;
+    uint32_t              signature;
+
+    FILE *                file;
+    uint32_t              text_size;
+    std::string           index_name;
+    std::vector<uint32_t> offsets;
+    uint32_t              saved_count;  // Offsets written to the index file
+    bool                  complete;
+    std::vector<char>     buffer;
+
+    SemaphoreHandle_t     mutex;
+    StaticSemaphore_t     mutex_buffer;
+    volatile bool         indexing;
+    volatile bool         stop_indexing;
+
+    uint32_t computeSignature();
+    bool      loadIndex();
+    void      saveIndex();
+    bool     addPage();
+    bool   layoutPage(uint32_t offset, uint32_t & next);
+
+    static void indexingTask(void * param);
+};
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+#include <cstdint>
+
+#include "defines.hpp"
+
+/**
+ * @brief Direct frame buffer pixel writer
+ *
+ * A PixelSink writes pixels straight into a frame buffer, with the display
+ * mode and the rotation resolved at compile time. It is built once per
+ * drawing primitive (see Graphics::withPixelSink()) and then used in the
+ * primitive's inner loop, avoiding the virtual writePixel() call, the
+ * rotation switch, the display mode test and the virtual frame buffer
+ * get_data() call for every pixel.
+ *
+ * Coordinates are logical (rotated) coordinates. drawPixel() clips
+ * against the sink's clipping rectangle, writePixel() doesn't and must
+ * only be called with coordinates known to be inside of it.
+ *
+ * @tparam MODE Display mode of the frame buffer
+ * @tparam ROTATION Screen rotation (0 to 3)
+ */
+template <DisplayMode MODE, uint8_t ROTATION>
+class PixelSink
+{
+  public:
+    static constexpr DisplayMode mode = MODE;
+
+    PixelSink(uint8_t * data, int16_t line_size, int16_t raw_width, int16_t raw_height) :
+      data(data), line_size(line_size), raw_width(raw_width), raw_height(raw_height),
+      clip_x0(0), clip_y0(0), clip_x1(width() - 1), clip_y1(height() - 1) {}
+
+    inline int16_t  width() const { return (ROTATION & 1) ? raw_height : raw_width;  }
+    inline int16_t height() const { return (ROTATION & 1) ? raw_width  : raw_height; }
+
+    inline void setClip(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+      clip_x0 = x0; clip_y0 = y0; clip_x1 = x1; clip_y1 = y1;
+    }
+
+    inline int16_t clipLeft()   const { return clip_x0; }
+    inline int16_t clipTop()    const { return clip_y0; }
+    inline int16_t clipRight()  const { return clip_x1; }
+    inline int16_t clipBottom() const { return clip_y1; }
+
+    inline bool contains(int16_t x, int16_t y) const {
+      return (x >= clip_x0) && (x <= clip_x1) && (y >= clip_y0) && (y <= clip_y1);
+    }
+
+    inline void drawPixel(int16_t x, int16_t y, uint16_t color) {
+      if (contains(x, y)) writePixel(x, y, color);
+    }
+
+    inline void writePixel(int16_t x, int16_t y, uint16_t color) {
+      int16_t px, py;
+
+      toPhysical(x, y, px, py);
+
+      if (MODE == DisplayMode::INKPLATE_1BIT) {
+        uint8_t * p    = &data[line_size * py + (px >> 3)];
+        uint8_t   mask = 1 << (px & 7);
+        *p = color ? (*p | mask) : (*p & ~mask);
+      }
+      else {
+        uint8_t * p = &data[line_size * py + (px >> 1)];
+        color &= 7;
+        *p = (px & 1) ? ((*p & 0xF0) | color) : ((*p & 0x0F) | (color << 4));
+      }
+    }
+
+    inline uint8_t getPixel(int16_t x, int16_t y) const {
+      int16_t px, py;
+
+      toPhysical(x, y, px, py);
+      if (MODE == DisplayMode::INKPLATE_1BIT) return (data[line_size * py + (px >> 3)] >> (px & 7)) & 1;
+      uint8_t b = data[line_size * py + (px >> 1)];
+      return (px & 1) ? (b & 7) : ((b >> 4) & 7);
+    }
+
+    /**
+     * @brief Write a row of pixel colors
+     *
+     * The row is clipped against the clipping rectangle once, the remaining
+     * pixels are written without further checks.
+     */
+    inline void writeRow(int16_t x, int16_t y, const uint8_t * colors, int16_t count) {
+      if ((y < clip_y0) || (y > clip_y1)) return;
+      int16_t first = (x < clip_x0) ? (clip_x0 - x) : 0;
+      int16_t last  = ((x + count - 1) > clip_x1) ? (clip_x1 - x) : (count - 1);
+      for (int16_t i = first; i <= last; i++) writePixel(x + i, y, colors[i]);
+    }
+
+  private:
+    inline void toPhysical(int16_t x, int16_t y, int16_t & px, int16_t & py) const {
+      switch (ROTATION) {
+        case 1:  px = raw_width - y - 1; py = x;                  break;
+        case 2:  px = raw_width - x - 1; py = raw_height - y - 1; break;
+        case 3:  px = y;                 py = raw_height - x - 1; break;
+        default: px = x;                 py = y;                  break;
+      }
+    }
+
+    uint8_t * data;
+    int16_t   line_size;
+    int16_t   raw_width, raw_height;
+    int16_t   clip_x0, clip_y0, clip_x1, clip_y1;
+};
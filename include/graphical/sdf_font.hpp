@@ -0,0 +1,42 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __SDF_FONT_HPP__
+#define __SDF_FONT_HPP__
+
+#include <cinttypes>
+
+/**
+ * @brief Signed distance field font
+ *
+ * Each glyph is a grid of distances to its outline, computed at a single em
+ * size: 128 on the outline, greater inside, smaller outside, changing by
+ * 128 / spread for each pixel. Such a grid is resampled at any size and
+ * thresholded at 128, the outline staying smooth (see SDFFontSource).
+ *
+ * These fonts are generated from TrueType or OpenType fonts with the
+ * tools/sdf_font_convert utility.
+ */
+typedef struct
+{
+	uint32_t bitmapOffset; ///< Pointer into SDFFont->bitmap
+	uint8_t  width;        ///< Distance field dimensions in pixels
+	uint8_t  height;       ///< Distance field dimensions in pixels
+	uint16_t xAdvance;     ///< Distance to advance cursor (x axis), in 1/16 pixels
+	int8_t   xOffset;      ///< X dist from cursor pos to UL corner
+	int8_t   yOffset;      ///< Y dist from cursor pos to UL corner
+} SDFGlyph;
+
+typedef struct
+{
+	uint8_t  * bitmap;     ///< Distance fields, one byte per pixel, concatenated
+	SDFGlyph * glyph;      ///< Glyph array
+	uint16_t   first;      ///< Extents (first char)
+	uint16_t   last;       ///< Extents (last char)
+	uint8_t    size;       ///< Em size the distance fields were computed at, in pixels
+	uint8_t    yAdvance;   ///< Newline distance (y axis) at that size
+	uint8_t    spread;     ///< Distance range, in pixels at that size
+} SDFFont;
+
+#endif // __SDF_FONT_HPP__
@@ -0,0 +1,86 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __SDF_FONT_SOURCE_HPP__
+#define __SDF_FONT_SOURCE_HPP__
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "font_source.hpp"
+#include "sdf_font.hpp"
+
+/**
+ * @brief A signed distance field font rendered at a chosen size
+ *
+ * Glyphs are rasterized from their distance field when first needed, at
+ * the current size, and kept in a least recently used cache of a bounded
+ * size: text drawn again costs a bitmap copy. The bitmaps hold 1 bit per
+ * pixel (crisp outline, for 1-bit mode) or the coverage on 2 or 4 bits
+ * (anti-aliased, for 3-bit mode).
+ *
+ *   SDFFontSource font(&LatoRegularSDF32, 72);
+ *   display.setFontSource(&font);
+ *   display.print("12:34");
+ *   font.setSize(20);
+ *   display.print("Monday");
+ *
+ * The size is the em size in pixels. It is limited such that the distance
+ * between lines stays below 256 pixels.
+ */
+class SDFFontSource : public FontSource
+{
+  public:
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 16 * 1024; // Bytes
+
+    SDFFontSource(const SDFFont * font, uint16_t size, uint8_t bpp = 1,
+                  uint32_t cache_size = DEFAULT_CACHE_SIZE);
+
+    /**
+     * @brief Change the size, dropping the cached glyphs
+     */
+    void    setSize(uint16_t size);
+    void     setBpp(uint8_t bpp);
+    void setCacheSize(uint32_t bytes);
+
+    bool   getGlyph(uint32_t codepoint, FontGlyph & glyph) override;
+    bool getMetrics(uint32_t codepoint, FontGlyph & glyph) override;
+
+    uint8_t getYAdvance() override { return y_advance; }
+
+    uint32_t getIdentity() override;
+
+    inline uint16_t   getSize() const { return size;   }
+    inline uint32_t   getHits() const { return hits;   }
+    inline uint32_t getMisses() const { return misses; }
+
+  private:
+    struct CachedGlyph {
+      uint32_t             codepoint;
+      FontGlyph            glyph;
+      std::vector<uint8_t> data;
+    };
+
+    typedef std::list<CachedGlyph> Cache;
+
+    const SDFFont * font;
+    uint16_t        size;
+    uint8_t         bpp;
+    uint8_t         y_advance;
+    float           scale;         // From the distance fields size
+
+    Cache                                        cache;
+    std::unordered_map<uint32_t, Cache::iterator> index;
+    uint32_t                                     cache_size;
+    uint32_t                                     cached_size;
+    uint32_t                                     hits, misses;
+
+    void   clear();
+    void    trim(uint32_t needed);
+    void setBox(const SDFGlyph & g, FontGlyph & glyph);
+    void rasterize(const SDFGlyph & g, CachedGlyph & entry);
+};
+
+#endif
@@ -20,9 +20,6 @@ Distributed as-is; no warranty is given.
 #include "defines.hpp"
 #include "adafruit_gfx.hpp"
 
-#define maxVer 100
-#define maxHt  600
-
 class Shapes : virtual public Adafruit_GFX
 {
   public:
@@ -32,33 +29,51 @@ class Shapes : virtual public Adafruit_GFX
 
     virtual void selectDisplayMode(DisplayMode mode) = 0;
     virtual DisplayMode getDisplayMode() = 0;
+    virtual Rect           getClipRect() = 0;
 
     void       drawElipse(int rx, int ry, int xc, int yc, int c);
     void       fillElipse(int rx, int ry, int xc, int yc, int c);
+    void  drawThickElipse(int rx, int ry, int xc, int yc, int thickness, int c);
+    void    drawElipseArc(int rx, int ry, int xc, int yc, int startAngle, int endAngle, int thickness, int c);
     void      drawPolygon(int *x, int *y, int  n, int color);
     void      fillPolygon(int *x, int *y, int  n, int color);
     void    drawThickLine(int x1, int y1, int x2, int y2, int color, float thickness);
+    void      drawCapsule(int x1, int y1, int x2, int y2, int color, float thickness);
+    void drawThickPolyline(int *x, int *y, int n, int color, float thickness);
     void drawGradientLine(int x1, int y1, int x2, int y2, int color1, int color2, float thickness = -1);
 
+  protected:
+    // Polygon interior spans, without the outline (shapes_polygon.cpp)
+    void fillPolygonSpans(int *x, int *y, int n, int color);
+
   private:
-    struct EdgeBucket {
-        int   ymax;
-        float xofymin;
-        float slopeinverse;
+    // Polygon edge, for the scanline filler. x and dx are fixed point, with a
+    // 16 bit fraction.
+    struct PolygonEdge {
+        int     ymin, ymax;
+        int64_t x, dx;
     };
 
-    struct edgeTableTuple {
-        int countEdgeBucket;
-        EdgeBucket buckets[maxVer];
+    // Elipse arc angular sector. d0 and d1 are the 1.12 fixed point direction
+    // vectors of the start and end rays. wide is true if more than 180 degrees.
+    struct ElipseSector {
+        int32_t d0x, d0y, d1x, d1y;
+        bool    wide;
     };
 
-    void     initedgeTable();
-    void     insertionSort(edgeTableTuple *ett);
-    void  storeEdgeInTuple(edgeTableTuple *receiver, int ym, int xm, float slopInv);
-    void  storeEdgeInTable(int x1, int y1, int x2, int y2);
-    void  removeEdgeByYmax(edgeTableTuple *tup, int yy);
-    void updatexbyslopeinv(edgeTableTuple *tup);
-    void      scanlineFill(uint8_t c);
+    // Integer square root, floor(sqrt(v)) (shapes.cpp)
+    static uint32_t isqrt(uint64_t v);
+
+    // Thick lines (shapes.cpp). Coordinates and half thickness are 16.16 fixed point.
+    static constexpr int MAX_DISC_RADIUS = 63; // Larger disc tables are allocated
+
+    void     fillQuadFx(const int32_t *vx, const int32_t *vy, int color);
+    void   thickSegment(int x1, int y1, int x2, int y2, int32_t half, bool extend, int color);
+    int16_t *discHalfWidths(int32_t half, int16_t *buffer, int & radius);
+    void       fillDisc(int xc, int yc, const int16_t *halfWidths, int radius, int color);
+
+    void elipseRows(int rx, int ry, int xc, int yc, int thickness, const ElipseSector * sector, int c);
+    void elipseSpan(int x0, int x1, int y, int xc, int yc, const ElipseSector * sector, int c);
 
     virtual void     startWrite(void) = 0;
     virtual void     writePixel(int16_t x, int16_t y, uint16_t color) = 0;
@@ -67,8 +82,6 @@ class Shapes : virtual public Adafruit_GFX
     virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) = 0;
     virtual void      writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) = 0;
     virtual void       endWrite(void) = 0;
-
-    edgeTableTuple *edgeTable, activeEdgeTuple;
 };
 
 #endif
\ No newline at end of file
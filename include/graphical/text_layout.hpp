@@ -0,0 +1,105 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#ifndef __TEXT_LAYOUT_HPP__
+#define __TEXT_LAYOUT_HPP__
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "graphics.hpp"
+#include "font_source.hpp"
+
+/**
+ * @brief Paragraph layout of UTF-8 text
+ *
+ * The text is measured once, with the font advance table and kerning, and
+ * broken in lines no wider than the layout width: at spaces, or inside a
+ * word when it doesn't fit on a line by itself. Newline characters end a
+ * line. The lines are then drawn aligned to the left, to the right, centered
+ * or justified (spaces are widened, except on the last line of a paragraph).
+ *
+ *   GFXFontSource font(&FreeSerif12pt7b);
+ *   TextLayout    layout(font, 400, TextLayout::Align::JUSTIFY);
+ *
+ *   layout.layout(text);
+ *   layout.draw(display, 20, 40, BLACK);
+ *
+ * The text is not copied: it must stay available until drawn.
+ */
+class TextLayout
+{
+  public:
+    enum class Align : uint8_t { LEFT, CENTER, RIGHT, JUSTIFY };
+
+    struct Line {
+      uint32_t start, end;       // Byte offsets in the text, trailing spaces excluded
+      int16_t  width;            // Pixels
+      uint16_t spaces;           // Count of spaces between start and end
+      bool     last;             // Last line of a paragraph (not justified)
+    };
+
+    /**
+     * @param width Maximum width of a line, in pixels. 0 for no wrapping.
+     */
+    TextLayout(FontSource & font, int16_t width = 0, Align align = Align::LEFT);
+
+    void        setWidth(int16_t w) { width = w;        }
+    void        setAlign(Align a)   { align = a;        }
+    void  setLineHeight(int16_t h)  { line_height = h;  }
+
+    /**
+     * @brief Limit the count of lines laid out
+     *
+     * The layout stops when the limit is reached: getEnd() then gives where
+     * the next line would start. 0 (the default) for no limit.
+     */
+    void    setMaxLines(uint16_t count) { max_lines = count; }
+
+    /**
+     * @brief Break the text in lines
+     *
+     * @return The count of lines.
+     */
+    uint16_t layout(const char * text, uint32_t length);
+    uint16_t layout(const char * text)        { return layout(text, strlen(text)); }
+    uint16_t layout(const std::string & text) { return layout(text.c_str(), text.size()); }
+
+    /**
+     * @brief Draw the lines
+     *
+     * @param x Left side of the lines.
+     * @param y Baseline of the first line.
+     */
+    void draw(Graphics & graphics, int16_t x, int16_t y, uint16_t color);
+
+    inline const std::vector<Line> & getLines() const { return lines; }
+    inline int16_t             getLineHeight() const { return line_height; }
+    inline int16_t                 getHeight() const { return lines.size() * line_height; }
+
+    /**
+     * @brief Byte offset where the layout stopped
+     *
+     * The length of the text when all of it was laid out.
+     */
+    inline uint32_t                   getEnd() const { return end; }
+
+    /**
+     * @brief Width of the widest line
+     */
+    int16_t getMaxWidth() const;
+
+  private:
+    FontSource &      font;
+    int16_t           width;
+    Align             align;
+    int16_t           line_height;
+    uint16_t          max_lines;
+    const char *      text;
+    uint32_t          end;
+    std::vector<Line> lines;
+};
+
+#endif
@@ -13,6 +13,8 @@ https://github.com/Bodmer/TJpg_Decoder
 #ifndef TJpg_Decoder_H
 #define TJpg_Decoder_H
 
+#include <cstdio>
+
 #include "tjpgd.hpp"
 
 #if defined(ESP8266) || defined(ESP32)
@@ -21,17 +23,24 @@ https://github.com/Bodmer/TJpg_Decoder
 
 #define TJPGD_WORKSPACE_SIZE 3100
 
+// Read-ahead buffer of a file input: the file is read by blocks of this size
+#define TJPGD_FILE_BUFFER_SIZE 4096
+
 enum
 {
     TJPG_ARRAY = 0,
     TJPG_FS_FILE,
-    TJPG_SD_FILE
+    TJPG_SD_FILE,
+    TJPG_STREAM
 };
 
 //------------------------------------------------------------------------------
 
 typedef bool (*SketchCallback)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *data, bool dither, bool invert);
 
+// Stream input: returns the number of bytes read (less than len at the end), or -1 on error
+typedef int32_t (*JpgReader)(void *context, uint8_t *buf, uint32_t len);
+
 class TJpg_Decoder
 {
 
@@ -49,6 +58,14 @@ class TJpg_Decoder
     JRESULT drawJpg(int32_t x, int32_t y, const uint8_t array[], uint32_t array_size, bool dither, bool invert);
     JRESULT getJpgSize(uint16_t *w, uint16_t *h, const uint8_t array[], uint32_t array_size);
 
+    // Decode from the current position of an opened file, without loading it
+    JRESULT drawJpg(int32_t x, int32_t y, FILE *file, bool dither, bool invert);
+    JRESULT getJpgSize(uint16_t *w, uint16_t *h, FILE *file);
+
+    // Decode from a stream (e.g. a download), read as needed
+    JRESULT drawJpg(int32_t x, int32_t y, JpgReader reader, void *context, bool dither, bool invert);
+    JRESULT getJpgSize(uint16_t *w, uint16_t *h, JpgReader reader, void *context);
+
     void setSwapBytes(bool swap);
 
     bool _swap = false;
@@ -57,6 +74,13 @@ class TJpg_Decoder
     uint32_t array_index = 0;
     uint32_t array_size = 0;
 
+    FILE *jpg_file = nullptr;
+    JpgReader jpg_reader = nullptr;
+    void *jpg_context = nullptr;
+    uint8_t *file_buffer = nullptr;
+    uint16_t file_index = 0;
+    uint16_t file_count = 0;
+
     // Must align workspace to a 32 bit boundary
     uint8_t workspace[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
 
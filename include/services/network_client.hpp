@@ -19,10 +19,12 @@ Distributed as-is; no warranty is given.
 
 #include <cstdint>
 
+#include "esp_http_client.h"
+
 class NetworkClient
 {
   public:
-    NetworkClient() : connected(false) {}
+    NetworkClient() : connected(false), stream(nullptr) {}
 
     bool joinAP(const char * ssid, const char * pass);
     void disconnect();
@@ -31,8 +33,19 @@ class NetworkClient
 
     uint8_t * downloadFile(const char * url, int32_t * defaultLen);
 
+    // Streamed download: the body is read as it arrives, by the caller's
+    // chunks, without being kept in memory. A single stream can be opened at
+    // a time. length receives the Content-Length, or -1 if not known
+    // (chunked response). readStream() returns the number of bytes read,
+    // less than len at the end of the body, or -1 on error.
+
+    bool   openStream(const char * url, int32_t * length = nullptr);
+    int32_t readStream(uint8_t * buf, int32_t len);
+    void  closeStream();
+
   private:
     bool connected;
+    esp_http_client_handle_t stream;
 };
 
 #if __NETWORK_CLIENT__
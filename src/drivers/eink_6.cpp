@@ -322,13 +322,17 @@ EInk6::update(FrameBuffer3Bit & frame_buffer)
 }
 
 void
-EInk6::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
+EInk6::partial_update(FrameBuffer1Bit & frame_buffer, bool force, int16_t first_row, int16_t last_row)
 {
   if (!partial_allowed && !force) {
     update(frame_buffer);
     return;
   }
 
+  if ((last_row < 0) || (last_row >= HEIGHT)) last_row = HEIGHT - 1;
+  if (first_row < 0) first_row = 0;
+  if (first_row > last_row) return;
+
   Wire::enter();
 
   ESP_LOGD(TAG, "Partial update...");
@@ -341,7 +345,17 @@ EInk6::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
   uint8_t * idata = frame_buffer.get_data();
   uint8_t * odata = d_memory_new->get_data();
 
+  // Rows outside of the requested ones are sent as no-op (0xFF) data
+
+  bool all_rows = (first_row == 0) && (last_row == HEIGHT - 1);
+  if (!all_rows) memset(p_buffer, 0xFF, BITMAP_SIZE_1BIT * 2);
+
   for (int i = 0; i < HEIGHT; i++) {
+    if (!all_rows && (((HEIGHT - 1 - i) < first_row) || ((HEIGHT - 1 - i) > last_row))) {
+      pos -= LINE_SIZE_1BIT;
+      n   -= LINE_SIZE_1BIT * 2;
+      continue;
+    }
     for (int j = 0; j < LINE_SIZE_1BIT; j++) {
       diffw =  odata[pos] & ~idata[pos];
       diffb = ~odata[pos] &  idata[pos];
@@ -381,7 +395,7 @@ EInk6::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
   turn_off();
 
   Wire::leave();
-  memcpy(d_memory_new->get_data(), frame_buffer.get_data(), BITMAP_SIZE_1BIT);
+  memcpy(&odata[first_row * LINE_SIZE_1BIT], &idata[first_row * LINE_SIZE_1BIT], (last_row - first_row + 1) * LINE_SIZE_1BIT);
 }
 
 void
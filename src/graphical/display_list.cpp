@@ -0,0 +1,389 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "display_list.hpp"
+
+#include <algorithm>
+
+// Rectangles touching or overlapping each other
+
+static inline bool adjacent(const Rect & a, const Rect & b)
+{
+    return (a.x <= b.x + b.w) && (b.x <= a.x + a.w) && (a.y <= b.y + b.h) && (b.y <= a.y + a.h);
+}
+
+static inline bool intersects(const Rect & a, const Rect & b)
+{
+    return (a.x < b.x + b.w) && (b.x < a.x + a.w) && (a.y < b.y + b.h) && (b.y < a.y + a.h);
+}
+
+static inline Rect bounding(const Rect & a, const Rect & b)
+{
+    int16_t x0 = std::min(a.x, b.x);
+    int16_t y0 = std::min(a.y, b.y);
+    int16_t x1 = std::max(a.x + a.w, b.x + b.w);
+    int16_t y1 = std::max(a.y + a.h, b.y + b.h);
+
+    return { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+}
+
+DisplayList::DisplayList(Graphics & graphics, uint16_t background) :
+    graphics(graphics), background(background), next_id(1)
+{
+}
+
+DisplayList::ItemId DisplayList::add(Item & item)
+{
+    item.id      = next_id++;
+    item.visible = true;
+    if (next_id == NO_ITEM) next_id = 1;
+
+    setBounds(item);
+    addDamage(item.bounds);
+    items.push_back(item);
+
+    return item.id;
+}
+
+DisplayList::ItemId DisplayList::addRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool filled)
+{
+    Item item = {};
+
+    item.kind  = filled ? Kind::FILLED_RECT : Kind::RECT;
+    item.x     = x;
+    item.y     = y;
+    item.w     = w;
+    item.h     = h;
+    item.color = color;
+
+    return add(item);
+}
+
+DisplayList::ItemId DisplayList::addLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color, uint8_t thickness)
+{
+    Item item = {};
+
+    item.kind      = Kind::LINE;
+    item.x         = x0;
+    item.y         = y0;
+    item.w         = x1;
+    item.h         = y1;
+    item.thickness = std::max<uint8_t>(thickness, 1);
+    item.color     = color;
+
+    return add(item);
+}
+
+DisplayList::ItemId DisplayList::addCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color, bool filled)
+{
+    Item item = {};
+
+    item.kind  = filled ? Kind::FILLED_CIRCLE : Kind::CIRCLE;
+    item.x     = x0;
+    item.y     = y0;
+    item.w     = r;
+    item.color = color;
+
+    return add(item);
+}
+
+DisplayList::ItemId DisplayList::addText(int16_t x, int16_t y, const std::string & text, const GFXfont * font, uint16_t color)
+{
+    Item item = {};
+
+    item.kind  = Kind::TEXT;
+    item.x     = x;
+    item.y     = y;
+    item.text  = text;
+    item.font  = font;
+    item.color = color;
+
+    return add(item);
+}
+
+DisplayList::ItemId DisplayList::addBitmap(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h, uint16_t color)
+{
+    Item item = {};
+
+    item.kind  = Kind::BITMAP;
+    item.x     = x;
+    item.y     = y;
+    item.w     = w;
+    item.h     = h;
+    item.data  = bitmap;
+    item.color = color;
+
+    return add(item);
+}
+
+DisplayList::ItemId DisplayList::addCanvas(int16_t x, int16_t y, const GFXcanvas8 * canvas, int16_t transparent)
+{
+    Item item = {};
+
+    item.kind  = Kind::CANVAS;
+    item.x     = x;
+    item.y     = y;
+    item.w     = canvas->width();
+    item.h     = canvas->height();
+    item.data  = canvas;
+    item.color = transparent;
+
+    return add(item);
+}
+
+DisplayList::Item * DisplayList::find(ItemId id)
+{
+    for (auto & item : items) {
+        if (item.id == id) return &item;
+    }
+    return nullptr;
+}
+
+bool DisplayList::moveTo(ItemId id, int16_t x, int16_t y)
+{
+    Item * item = find(id);
+    if (item == nullptr) return false;
+
+    if ((item->x == x) && (item->y == y)) return true;
+
+    if (item->kind == Kind::LINE) {
+        item->w += x - item->x;
+        item->h += y - item->y;
+    }
+    item->x = x;
+    item->y = y;
+
+    addDamage(item->bounds);
+    setBounds(*item);
+    addDamage(item->bounds);
+
+    return true;
+}
+
+bool DisplayList::setColor(ItemId id, uint16_t color)
+{
+    Item * item = find(id);
+    if (item == nullptr) return false;
+
+    if (item->color != color) {
+        item->color = color;
+        addDamage(item->bounds);
+    }
+    return true;
+}
+
+bool DisplayList::setText(ItemId id, const std::string & text)
+{
+    Item * item = find(id);
+    if ((item == nullptr) || (item->kind != Kind::TEXT)) return false;
+
+    if (item->text != text) {
+        addDamage(item->bounds);
+        item->text = text;
+        setBounds(*item);
+        addDamage(item->bounds);
+    }
+    return true;
+}
+
+bool DisplayList::setVisible(ItemId id, bool visible)
+{
+    Item * item = find(id);
+    if (item == nullptr) return false;
+
+    if (item->visible != visible) {
+        item->visible = visible;
+        addDamage(item->bounds);
+    }
+    return true;
+}
+
+bool DisplayList::touch(ItemId id)
+{
+    Item * item = find(id);
+    if (item == nullptr) return false;
+
+    addDamage(item->bounds);
+    return true;
+}
+
+bool DisplayList::remove(ItemId id)
+{
+    for (auto it = items.begin(); it != items.end(); it++) {
+        if (it->id == id) {
+            if (it->visible) addDamage(it->bounds);
+            items.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DisplayList::clear()
+{
+    for (auto & item : items) {
+        if (item.visible) addDamage(item.bounds);
+    }
+    items.clear();
+}
+
+void DisplayList::invalidate()
+{
+    addDamage({ 0, 0, graphics.width(), graphics.height() });
+}
+
+void DisplayList::setBackground(uint16_t color)
+{
+    if (background != color) {
+        background = color;
+        invalidate();
+    }
+}
+
+// Text items are measured and drawn with their own font, unscaled and
+// unwrapped. The caller's text settings are kept aside meanwhile.
+
+void DisplayList::setTextStyle(const Item & item)
+{
+    graphics.setFontSource(nullptr);
+    graphics.setFont(item.font);
+    graphics.setTextSize(1);
+    graphics.setTextWrap(false);
+}
+
+void DisplayList::setBounds(Item & item)
+{
+    switch (item.kind) {
+        case Kind::LINE: {
+            // A thick line doesn't go further than its thickness from its ends
+
+            int16_t t = item.thickness;
+            int16_t x0 = std::min(item.x, item.w) - t, x1 = std::max(item.x, item.w) + t;
+            int16_t y0 = std::min(item.y, item.h) - t, y1 = std::max(item.y, item.h) + t;
+            item.bounds = { x0, y0, (int16_t)(x1 - x0 + 1), (int16_t)(y1 - y0 + 1) };
+            break;
+        }
+        case Kind::CIRCLE:
+        case Kind::FILLED_CIRCLE:
+            item.bounds = { (int16_t)(item.x - item.w), (int16_t)(item.y - item.w),
+                            (int16_t)(2 * item.w + 1),  (int16_t)(2 * item.w + 1) };
+            break;
+
+        case Kind::TEXT: {
+            int16_t  x = item.x, y = item.y;
+            uint16_t w = 0, h = 0;
+
+            Graphics::TextState state = graphics.getTextState();
+            setTextStyle(item);
+            if (!item.text.empty()) graphics.getTextBounds(item.text, item.x, item.y, &x, &y, &w, &h);
+            graphics.setTextState(state);
+
+            item.bounds = { x, y, (int16_t) w, (int16_t) h };
+            break;
+        }
+        default:
+            item.bounds = { item.x, item.y, item.w, item.h };
+            break;
+    }
+}
+
+void DisplayList::addDamage(const Rect & rect)
+{
+    // Limited to the screen
+
+    int16_t x0 = std::max<int16_t>(rect.x, 0);
+    int16_t y0 = std::max<int16_t>(rect.y, 0);
+    int16_t x1 = std::min<int32_t>(rect.x + rect.w, graphics.width());
+    int16_t y1 = std::min<int32_t>(rect.y + rect.h, graphics.height());
+
+    if ((x0 >= x1) || (y0 >= y1)) return;
+
+    // Merged with the areas it touches, until none is left
+
+    Rect r = { x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+
+    for (size_t i = 0; i < damage.size();) {
+        if (adjacent(r, damage[i])) {
+            r = bounding(r, damage[i]);
+            damage.erase(damage.begin() + i);
+            i = 0;
+        }
+        else i++;
+    }
+
+    damage.push_back(r);
+
+    if (damage.size() > MAX_DAMAGE) {
+        for (size_t i = 1; i < damage.size(); i++) damage[0] = bounding(damage[0], damage[i]);
+        damage.resize(1);
+    }
+}
+
+void DisplayList::draw(const Item & item)
+{
+    switch (item.kind) {
+        case Kind::RECT:
+            graphics.drawRect(item.x, item.y, item.w, item.h, item.color);
+            break;
+        case Kind::FILLED_RECT:
+            graphics.fillRect(item.x, item.y, item.w, item.h, item.color);
+            break;
+        case Kind::LINE:
+            if (item.thickness > 1)
+                graphics.drawThickLine(item.x, item.y, item.w, item.h, item.color, item.thickness);
+            else
+                graphics.drawLine(item.x, item.y, item.w, item.h, item.color);
+            break;
+        case Kind::CIRCLE:
+            graphics.drawCircle(item.x, item.y, item.w, item.color);
+            break;
+        case Kind::FILLED_CIRCLE:
+            graphics.fillCircle(item.x, item.y, item.w, item.color);
+            break;
+        case Kind::TEXT: {
+            Graphics::TextState state = graphics.getTextState();
+            setTextStyle(item);
+            graphics.setTextColor(item.color);
+            graphics.setCursor(item.x, item.y);
+            graphics.print(item.text);
+            graphics.setTextState(state);
+            break;
+        }
+        case Kind::BITMAP:
+            graphics.drawBitmap(item.x, item.y, (const uint8_t *) item.data, item.w, item.h, item.color);
+            break;
+        case Kind::CANVAS:
+            graphics.drawCanvas(item.x, item.y, *(const GFXcanvas8 *) item.data, (int16_t) item.color);
+            break;
+    }
+}
+
+bool DisplayList::render(bool update)
+{
+    if (damage.empty()) return false;
+
+    Rect all = damage[0];
+
+    for (auto & r : damage) {
+        all = bounding(all, r);
+
+        graphics.pushClipRect(r);
+        graphics.fillRect(r.x, r.y, r.w, r.h, background);
+        for (auto & item : items) {
+            if (item.visible && intersects(item.bounds, r)) draw(item);
+        }
+        graphics.popClipRect();
+    }
+
+    damage.clear();
+
+    if (update) {
+        if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT)
+            graphics.partialUpdate(all);
+        else
+            graphics.display();
+    }
+
+    return true;
+}
@@ -0,0 +1,284 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "font_file.hpp"
+#include "logging.hpp"
+#include "miniz.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+constexpr char FontFile::MAGIC[4];
+
+bool FontFile::open(const char * filename)
+{
+    close();
+
+    if ((file = fopen(filename, "rb")) == nullptr) {
+        ESP_LOGE(TAG, "Unable to open font file %s.", filename);
+        return false;
+    }
+
+    // Version 1 files have no kerning table, their header ending before
+    // kerning_count
+
+    const size_t v1_size = offsetof(Header, kerning_count);
+
+    if ((fread(&header, v1_size, 1, file) != 1) ||
+        (memcmp(header.magic, MAGIC, 4) != 0) ||
+        (header.version < 1) || (header.version > VERSION) ||
+        ((header.version > 1) && (fread(&header.kerning_count, sizeof(Header) - v1_size, 1, file) != 1)) ||
+        ((header.bpp != 1) && (header.bpp != 2) && (header.bpp != 4))) {
+        ESP_LOGE(TAG, "%s is not a supported font file.", filename);
+        close();
+        return false;
+    }
+
+    // The counts are checked against the file size before anything is
+    // allocated: a corrupted header could otherwise ask for any amount
+
+    long     start = ftell(file);
+    uint64_t index_size = (uint64_t) header.range_count   * sizeof(Range) +
+                          (uint64_t) header.glyph_count   * sizeof(Glyph) +
+                          (uint64_t) header.page_count    * sizeof(Page)  +
+                          (uint64_t) header.kerning_count * sizeof(Kerning);
+
+    if ((start < 0) || (fseek(file, 0, SEEK_END) != 0) || ((file_size = ftell(file)) < start) ||
+        (index_size > (uint64_t) (file_size - start)) || (fseek(file, start, SEEK_SET) != 0)) {
+        ESP_LOGE(TAG, "Font file %s is truncated.", filename);
+        close();
+        return false;
+    }
+
+    ranges.resize(header.range_count);
+    glyphs.resize(header.glyph_count);
+    pages.resize(header.page_count);
+    kernings.resize(header.kerning_count);
+
+    if ((fread(ranges.data(), sizeof(Range), ranges.size(), file) != ranges.size()) ||
+        (fread(glyphs.data(), sizeof(Glyph), glyphs.size(), file) != glyphs.size()) ||
+        (fread(pages.data(),  sizeof(Page),  pages.size(),  file) != pages.size()) ||
+        (fread(kernings.data(), sizeof(Kerning), kernings.size(), file) != kernings.size())) {
+        ESP_LOGE(TAG, "Font file %s is truncated.", filename);
+        close();
+        return false;
+    }
+
+    if (!validIndex()) {
+        ESP_LOGE(TAG, "Font file %s is corrupted.", filename);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool FontFile::validIndex() const
+{
+    // The ranges must not give indexes past the glyphs, and the pages must
+    // be within the file, in glyph order
+
+    uint64_t count = 0;
+    for (auto & r : ranges) count += r.count;
+    if (count > glyphs.size()) return false;
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        const Page & p = pages[i];
+        if ((p.raw_size > MAX_PAGE_SIZE) ||
+            ((uint64_t) p.file_offset + p.size > (uint64_t) file_size) ||
+            ((i > 0) && (p.first_glyph < pages[i - 1].first_glyph))) return false;
+    }
+
+    return true;
+}
+
+void FontFile::close()
+{
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+
+    ranges.clear();
+    glyphs.clear();
+    pages.clear();
+    kernings.clear();
+    cache.clear();
+    cached_size = 0;
+    file_size   = 0;
+    memset(&header, 0, sizeof(Header));
+    clearAdvances();
+}
+
+void FontFile::setCacheSize(uint32_t bytes)
+{
+    cache_size = bytes;
+    trim(0);
+}
+
+uint32_t FontFile::getIdentity()
+{
+    // FNV-1a hash of the file size, the header and the ranges
+
+    uint32_t hash = 2166136261U;
+
+    auto mix = [&hash](const void * data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= ((const uint8_t *) data)[i];
+            hash *= 16777619U;
+        }
+    };
+
+    mix(&file_size, sizeof(file_size));
+    mix(&header, sizeof(Header));
+    mix(ranges.data(), ranges.size() * sizeof(Range));
+
+    return hash;
+}
+
+int32_t FontFile::glyphIndex(uint32_t codepoint) const
+{
+    // Ranges are sorted by code point and their glyph indexes follow each
+    // other. A prefix sum is not kept: the count of ranges is small.
+
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), codepoint,
+                               [](uint32_t cp, const Range & r) { return cp < r.first; });
+
+    if (it == ranges.begin()) return -1;
+    --it;
+    if (codepoint >= it->first + it->count) return -1;
+
+    int32_t index = codepoint - it->first;
+    for (auto r = ranges.begin(); r != it; r++) index += r->count;
+
+    return index;
+}
+
+void FontFile::setMetrics(const Glyph & g, FontGlyph & glyph) const
+{
+    glyph.bpp         = header.bpp;
+    glyph.stride_bits = (g.width * header.bpp + 7) & ~7;
+    glyph.width       = g.width;
+    glyph.height      = g.height;
+    glyph.x_advance   = g.x_advance;
+    glyph.x_offset    = g.x_offset;
+    glyph.y_offset    = g.y_offset;
+    glyph.bitmap      = nullptr;
+}
+
+bool FontFile::getMetrics(uint32_t codepoint, FontGlyph & glyph)
+{
+    if (file == nullptr) return false;
+
+    int32_t index = glyphIndex(codepoint);
+    if (index < 0) return false;
+
+    setMetrics(glyphs[index], glyph);
+
+    return true;
+}
+
+int8_t FontFile::getKerning(uint32_t left, uint32_t right)
+{
+    if (kernings.empty()) return 0;
+
+    auto it = std::lower_bound(kernings.begin(), kernings.end(), std::make_pair(left, right),
+                               [](const Kerning & k, const std::pair<uint32_t, uint32_t> & p) {
+                                   return (k.left < p.first) || ((k.left == p.first) && (k.right < p.second));
+                               });
+
+    return ((it != kernings.end()) && (it->left == left) && (it->right == right)) ? it->value : 0;
+}
+
+bool FontFile::getGlyph(uint32_t codepoint, FontGlyph & glyph)
+{
+    if (file == nullptr) return false;
+
+    int32_t index = glyphIndex(codepoint);
+    if (index < 0) return false;
+
+    // Page holding this glyph: the last one starting at or before it
+
+    auto page = std::upper_bound(pages.begin(), pages.end(), (uint32_t) index,
+                                 [](uint32_t i, const Page & p) { return i < p.first_glyph; });
+    if (page == pages.begin()) return false;
+    --page;
+
+    const Glyph & g = glyphs[index];
+
+    setMetrics(g, glyph);
+
+    if ((g.width == 0) || (g.height == 0)) return true;
+
+    // The bitmap must be within its page
+
+    uint32_t size = (uint32_t) (glyph.stride_bits >> 3) * g.height;
+    if ((uint32_t) g.offset + size > page->raw_size) {
+        ESP_LOGE(TAG, "Glyph of code point %u is out of its page.", (unsigned) codepoint);
+        return false;
+    }
+
+    const uint8_t * data = getPage(page - pages.begin());
+    if (data == nullptr) return false;
+
+    glyph.bitmap = &data[g.offset];
+
+    return true;
+}
+
+const uint8_t * FontFile::getPage(uint16_t index)
+{
+    for (auto it = cache.begin(); it != cache.end(); it++) {
+        if (it->index == index) {
+            hits++;
+            if (it != cache.begin()) cache.splice(cache.begin(), cache, it);
+            return cache.front().data.data();
+        }
+    }
+
+    misses++;
+
+    const Page & page = pages[index];
+
+    trim(page.raw_size);
+
+    CachedPage entry;
+    entry.index = index;
+    entry.data.resize(page.raw_size);
+
+    bool ok = fseek(file, page.file_offset, SEEK_SET) == 0;
+
+    if (ok) {
+        if (header.compression == (uint8_t) Compression::ZLIB) {
+            std::vector<uint8_t> packed(page.size);
+            ok = (fread(packed.data(), 1, page.size, file) == page.size) &&
+                 (tinfl_decompress_mem_to_mem(entry.data.data(), page.raw_size, packed.data(), page.size,
+                                              TINFL_FLAG_PARSE_ZLIB_HEADER) == page.raw_size);
+        }
+        else {
+            ok = fread(entry.data.data(), 1, page.raw_size, file) == page.raw_size;
+        }
+    }
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Unable to read font page %u.", index);
+        return nullptr;
+    }
+
+    cache.push_front(std::move(entry));
+    cached_size += page.raw_size;
+
+    return cache.front().data.data();
+}
+
+void FontFile::trim(uint32_t needed)
+{
+    // The page being loaded is kept even if larger than the cache size
+
+    while (!cache.empty() && (cached_size + needed > cache_size)) {
+        cached_size -= cache.back().data.size();
+        cache.pop_back();
+    }
+}
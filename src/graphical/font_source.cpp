@@ -0,0 +1,55 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "font_source.hpp"
+
+int16_t FontSource::getAdvance(uint32_t codepoint)
+{
+    FontGlyph glyph;
+
+    if (codepoint < LOW_COUNT) {
+        if (!low_advances_ready) {
+            for (uint16_t c = 0; c < LOW_COUNT; c++) {
+                low_advances[c] = getMetrics(c, glyph) ? glyph.x_advance : -1;
+            }
+            low_advances_ready = true;
+        }
+        return low_advances[codepoint];
+    }
+
+    auto it = high_advances.find(codepoint);
+    if (it != high_advances.end()) return it->second;
+
+    int16_t advance = getMetrics(codepoint, glyph) ? glyph.x_advance : -1;
+    high_advances[codepoint] = advance;
+
+    return advance;
+}
+
+void FontSource::mixIdentity(uint32_t & hash, uint32_t value)
+{
+    for (int i = 0; i < 4; i++, value >>= 8) {
+        hash ^= value & 0xFF;
+        hash *= 16777619U;
+    }
+}
+
+uint32_t GFXFontSource::getIdentity()
+{
+    // The range, the line height, the bit depth and the glyph table, as
+    // fonts with the same range differ by their glyph metrics
+
+    uint32_t hash = 2166136261U;
+
+    mixIdentity(hash, ((uint32_t) font->first << 16) | font->last);
+    mixIdentity(hash, ((uint32_t) font->yAdvance << 8) | bpp);
+
+    for (uint32_t i = 0; i <= (uint32_t) (font->last - font->first); i++) {
+        const GFXglyph * g = &font->glyph[i];
+        mixIdentity(hash, ((uint32_t) g->bitmapOffset << 16) | ((uint32_t) g->width << 8) | g->height);
+        mixIdentity(hash, ((uint32_t) g->xAdvance << 16) | ((uint32_t) (uint8_t) g->xOffset << 8) | (uint8_t) g->yOffset);
+    }
+
+    return hash;
+}
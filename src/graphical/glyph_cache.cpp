@@ -0,0 +1,64 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "glyph_cache.hpp"
+
+const GlyphCache::Entry * GlyphCache::find(const Key & key)
+{
+    auto it = index.find(key);
+
+    if (it == index.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    hits++;
+    if (it->second != entries.begin()) entries.splice(entries.begin(), entries, it->second);
+
+    return &*it->second;
+}
+
+const GlyphCache::Entry * GlyphCache::insert(Entry && entry)
+{
+    if (!accepts(entry.data.size())) return nullptr;
+
+    uint32_t needed = entrySize(entry);
+
+    auto it = index.find(entry.key);
+    if (it != index.end()) {
+        size -= entrySize(*it->second);
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    evict(needed);
+
+    entries.push_front(std::move(entry));
+    index[entries.front().key] = entries.begin();
+    size += needed;
+
+    return &entries.front();
+}
+
+void GlyphCache::evict(uint32_t needed)
+{
+    while (!entries.empty() && (size + needed > capacity)) {
+        size -= entrySize(entries.back());
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+void GlyphCache::setCapacity(uint32_t bytes)
+{
+    capacity = bytes;
+    evict(0);
+}
+
+void GlyphCache::clear()
+{
+    index.clear();
+    entries.clear();
+    size = 0;
+}
@@ -32,6 +32,8 @@ Graphics::Graphics(int16_t w, int16_t h) :
     _partial->clear();
     DMemory4Bit->clear();
   }
+
+  resetClipRect();
 };
 
 void Graphics::setRotation(uint8_t x)
@@ -50,81 +52,97 @@ void Graphics::setRotation(uint8_t x)
         _height = e_ink.get_width();
         break;
     }
+    resetClipRect();
 }
 
-uint8_t Graphics::getRotation()
+void Graphics::resetClipRect()
 {
-    return rotation;
+    clip_depth = 0;
+    clip_x0    = 0;
+    clip_y0    = 0;
+    clip_x1    = _width  - 1;
+    clip_y1    = _height - 1;
 }
 
-void Graphics::drawPixel(int16_t x0, int16_t y0, uint16_t color)
+bool Graphics::pushClipRect(int16_t x, int16_t y, int16_t w, int16_t h)
 {
-    writePixel(x0, y0, color); // Specified in boards folder
-}
+    if (clip_depth >= CLIP_STACK_SIZE)
+    {
+        ESP_LOGE(TAG, "Clipping stack overflow.");
+        return false;
+    }
 
-void Graphics::startWrite()
-{
-}
+    clip_stack[clip_depth++] = getClipRect();
 
-void Graphics::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
-{
-    for (int i = 0; i < h; ++i)
-        for (int j = 0; j < w; ++j)
-            writePixel(x + j, y + i, color);
+    // Intersection with the current rectangle. It may be empty.
+
+    int32_t x1 = (int32_t)x + w - 1;
+    int32_t y1 = (int32_t)y + h - 1;
+
+    if (x > clip_x0) clip_x0 = x;
+    if (y > clip_y0) clip_y0 = y;
+    if (x1 < clip_x1) clip_x1 = x1;
+    if (y1 < clip_y1) clip_y1 = y1;
+
+    return true;
 }
 
-void Graphics::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+bool Graphics::popClipRect()
 {
-    for (int i = 0; i < h; ++i)
-        writePixel(x, y + i, color);
+    if (clip_depth == 0) return false;
+
+    const Rect & r = clip_stack[--clip_depth];
+
+    clip_x0 = r.x;
+    clip_y0 = r.y;
+    clip_x1 = r.x + r.w - 1;
+    clip_y1 = r.y + r.h - 1;
+
+    return true;
 }
 
-void Graphics::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+Rect Graphics::getClipRect()
 {
-    for (int j = 0; j < w; ++j)
-        writePixel(x + j, y, color);
+    return { clip_x0, clip_y0, (int16_t)(clip_x1 - clip_x0 + 1), (int16_t)(clip_y1 - clip_y0 + 1) };
 }
 
-void Graphics::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+bool Graphics::clipRect(int16_t & x, int16_t & y, int16_t & w, int16_t & h, int16_t & dx, int16_t & dy)
 {
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
-    if (steep)
-    {
-        std::swap(x0, y0);
-        std::swap(x1, y1);
-    }
+    // dx and dy receive the position of the clipped rectangle relative to
+    // the original one
 
-    if (x0 > x1)
-    {
-        std::swap(x0, x1);
-        std::swap(y0, y1);
-    }
+    int32_t x1 = (int32_t)x + w - 1;
+    int32_t y1 = (int32_t)y + h - 1;
 
-    int16_t dx, dy;
-    dx = x1 - x0;
-    dy = abs(y1 - y0);
+    dx = (x < clip_x0) ? clip_x0 - x : 0;
+    dy = (y < clip_y0) ? clip_y0 - y : 0;
 
-    int16_t err = dx >> 1;
-    int16_t ystep;
+    if (x1 > clip_x1) x1 = clip_x1;
+    if (y1 > clip_y1) y1 = clip_y1;
 
-    if (y0 < y1)
-        ystep = 1;
-    else
-        ystep = -1;
+    x += dx;
+    y += dy;
 
-    for (; x0 <= x1; x0++)
-    {
-        if (steep)
-            writePixel(y0, x0, color);
-        else
-            writePixel(x0, y0, color);
-        err -= dy;
-        if (err < 0)
-        {
-            y0 += ystep;
-            err += dx;
-        }
-    }
+    if ((x > x1) || (y > y1)) return false;
+
+    w = x1 - x + 1;
+    h = y1 - y + 1;
+
+    return true;
+}
+
+uint8_t Graphics::getRotation()
+{
+    return rotation;
+}
+
+void Graphics::drawPixel(int16_t x0, int16_t y0, uint16_t color)
+{
+    writePixel(x0, y0, color); // Specified in boards folder
+}
+
+void Graphics::startWrite()
+{
 }
 
 void Graphics::endWrite()
@@ -180,6 +198,28 @@ void Graphics::partialUpdate(bool _forced)
   }
 }
 
+void Graphics::partialUpdate(const Rect & region, bool _forced)
+{
+  // Only the frame buffer rows covered by the region are updated
+
+  if ((display_mode != DisplayMode::INKPLATE_1BIT) || (region.w <= 0) || (region.h <= 0)) return;
+
+  int16_t first, last;
+
+  switch (rotation) {
+    case 1:  first = region.x;                       last = region.x + region.w - 1; break;
+    case 2:  first = HEIGHT - region.y - region.h;   last = HEIGHT - 1 - region.y;   break;
+    case 3:  first = HEIGHT - region.x - region.w;   last = HEIGHT - 1 - region.x;   break;
+    default: first = region.y;                       last = region.y + region.h - 1; break;
+  }
+
+  if (first < 0) first = 0;
+  if (last >= HEIGHT) last = HEIGHT - 1;
+  if (first > last) return;
+
+  e_ink.partial_update(*_partial, _forced, first, last);
+}
+
 int16_t Graphics::width()
 {
     return _width;
@@ -192,7 +232,7 @@ int16_t Graphics::height()
 
 void Graphics::writePixel(int16_t x0, int16_t y0, uint16_t color)
 {
-    if (x0 > width() - 1 || y0 > height() - 1 || x0 < 0 || y0 < 0)
+    if (x0 > clip_x1 || y0 > clip_y1 || x0 < clip_x0 || y0 < clip_y0)
         return;
 
     switch (rotation)
@@ -0,0 +1,412 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// 1-bit blit engine. A source rectangle of a 1-bit bitmap is combined with
+// the frame buffer using a raster operation. In 1-bit mode without
+// rotation, rows are processed a destination byte at a time: the source
+// bits are shifted in place with a 16 bit window, and the aligned COPY
+// case is a memcpy().
+//
+// With a rotation, the source is first brought to the frame buffer
+// orientation, and then goes through the same row code. For rotation 2,
+// rows are bit reversed. For rotations 1 and 3, logical columns become
+// frame buffer rows: the source is read in 8x8 bit blocks that are
+// transposed with a few shifts and masks, 8 columns at a time.
+//
+// In 3-bit mode with rotation 1 or 3, two vertically adjacent pixels share
+// a frame buffer byte: they are written in pairs, a byte at a time.
+
+#include "graphics.hpp"
+
+#include <cstring>
+
+// Bit reversal table, to convert most significant bit first bitmaps (the
+// Adafruit_GFX format) to the frame buffer bit order.
+
+static const uint8_t reversed[256] = {
+    0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+    0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
+    0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+    0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
+    0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
+    0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+    0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
+    0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
+    0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+    0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
+    0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
+    0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+    0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+    0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
+    0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+    0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
+};
+
+template <RasterOp OP>
+static inline uint8_t rasterOp(uint8_t d, uint8_t s)
+{
+    switch (OP) {
+        case RasterOp::OR:      return d | s;
+        case RasterOp::AND:     return d & s;
+        case RasterOp::XOR:     return d ^ s;
+        case RasterOp::NOT:     return ~s;
+        case RasterOp::AND_NOT: return d & ~s;
+        default:                return s;
+    }
+}
+
+// Same operations on a 3-bit gray level, a set source bit standing for black
+
+static inline uint8_t rasterOpGray(RasterOp op, uint8_t d, bool s)
+{
+    switch (op) {
+        case RasterOp::OR:      return s ? 0 : d;
+        case RasterOp::AND:     return s ? d : 7;
+        case RasterOp::XOR:     return s ? 7 - d : d;
+        case RasterOp::NOT:     return s ? 7 : 0;
+        case RasterOp::AND_NOT: return s ? 7 : d;
+        default:                return s ? 0 : 7;
+    }
+}
+
+// One row of n bits, from source bit sbit to destination bit dbit. The
+// source row is src_bytes long, and is never read past its end.
+
+template <RasterOp OP, bool LSB_FIRST>
+static void blitRow(uint8_t * dst, int16_t dbit, const uint8_t * src, int16_t src_bytes, int32_t sbit, int16_t n)
+{
+    auto byte = [&](int32_t i) -> uint8_t {
+        if (i >= src_bytes) return 0;
+        return LSB_FIRST ? src[i] : reversed[src[i]];
+    };
+
+    // 8 source bits, starting at bit pos
+    auto fetch = [&](int32_t pos) -> uint8_t {
+        int32_t i  = pos >> 3;
+        uint8_t sh = pos & 7;
+        if (sh == 0) return byte(i);
+        return (byte(i) >> sh) | (byte(i + 1) << (8 - sh));
+    };
+
+    int16_t   last = dbit + n - 1;
+    uint8_t * d    = &dst[dbit >> 3];
+    uint8_t * e    = &dst[last >> 3];
+
+    // First (possibly partial) destination byte
+
+    uint8_t mask = 0xFF << (dbit & 7);
+    if (d == e) mask &= 0xFF >> (7 - (last & 7));
+
+    uint8_t s = fetch(sbit) << (dbit & 7);
+    *d = (*d & ~mask) | (rasterOp<OP>(*d, s) & mask);
+
+    if (d == e) return;
+
+    int32_t pos = sbit + 8 - (dbit & 7);
+    d++;
+
+    // Complete bytes
+
+    if ((OP == RasterOp::COPY) && LSB_FIRST && ((pos & 7) == 0)) {
+        int16_t count = e - d;
+        memcpy(d, &src[pos >> 3], count);
+        d   += count;
+        pos += count << 3;
+    }
+    else {
+        for (; d < e; d++, pos += 8) *d = rasterOp<OP>(*d, fetch(pos));
+    }
+
+    // Last (possibly partial) byte
+
+    mask = 0xFF >> (7 - (last & 7));
+    s    = fetch(pos);
+    *d   = (*d & ~mask) | (rasterOp<OP>(*d, s) & mask);
+}
+
+static void blitRowLsb(RasterOp op, uint8_t * dst, int16_t dbit, const uint8_t * src, int16_t src_bytes, int32_t sbit, int16_t n)
+{
+    switch (op) {
+        case RasterOp::OR:      blitRow<RasterOp::OR,      true>(dst, dbit, src, src_bytes, sbit, n); break;
+        case RasterOp::AND:     blitRow<RasterOp::AND,     true>(dst, dbit, src, src_bytes, sbit, n); break;
+        case RasterOp::XOR:     blitRow<RasterOp::XOR,     true>(dst, dbit, src, src_bytes, sbit, n); break;
+        case RasterOp::NOT:     blitRow<RasterOp::NOT,     true>(dst, dbit, src, src_bytes, sbit, n); break;
+        case RasterOp::AND_NOT: blitRow<RasterOp::AND_NOT, true>(dst, dbit, src, src_bytes, sbit, n); break;
+        default:                blitRow<RasterOp::COPY,    true>(dst, dbit, src, src_bytes, sbit, n); break;
+    }
+}
+
+template <RasterOp OP>
+static void blitRows(uint8_t * dst, int16_t line_size, int16_t dx, const uint8_t * src, int16_t stride,
+                     int32_t sx, int16_t w, int16_t h, bool lsb_first)
+{
+    for (int16_t j = 0; j < h; j++, dst += line_size, src += stride) {
+        if (lsb_first)
+            blitRow<OP, true >(dst, dx, src, stride, sx, w);
+        else
+            blitRow<OP, false>(dst, dx, src, stride, sx, w);
+    }
+}
+
+// 8 source bits starting at bit pos of a row, least significant bit first
+
+static inline uint8_t sourceByte(const uint8_t * row, int16_t stride, int32_t pos, bool lsb_first)
+{
+    auto byte = [&](int32_t i) -> uint8_t {
+        if (i >= stride) return 0;
+        return lsb_first ? row[i] : reversed[row[i]];
+    };
+
+    int32_t i  = pos >> 3;
+    uint8_t sh = pos & 7;
+    if (sh == 0) return byte(i);
+    return (byte(i) >> sh) | (byte(i + 1) << (8 - sh));
+}
+
+// Transpose of an 8x8 bit matrix, byte i being row i and bit j column j
+// (Hacker's Delight, section 7-3).
+
+static inline uint64_t transpose8x8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x << 28)) & 0x0F0F0F0F00000000ULL; x ^= t ^ (t >> 28);
+    t = (x ^ (x << 14)) & 0x3333000033330000ULL; x ^= t ^ (t >> 14);
+    t = (x ^ (x <<  7)) & 0x5500550055005500ULL; x ^= t ^ (t >>  7);
+
+    return x;
+}
+
+// Reverse the order of the n bits of a row of bytes. The result is
+// right aligned: it starts at bit (bytes * 8 - n) of dst.
+
+static inline void reverseBits(uint8_t * dst, const uint8_t * src, int16_t bytes)
+{
+    for (int16_t i = 0; i < bytes; i++) dst[bytes - 1 - i] = reversed[src[i]];
+}
+
+// 3-bit mode, rotation 1 or 3: logical columns are frame buffer rows, and
+// logical pixels (x, y) and (x, y + 1) are in the same frame buffer byte when
+// the first one falls on an even physical column. The function color(i, j, d)
+// returns the new gray level of pixel (x + i, y + j), whose current level is
+// d. The rectangle must be already clipped.
+
+template <typename F>
+static void writeNibblePairs(uint8_t * data, int16_t line_size, int16_t raw_width, int16_t raw_height, uint8_t rotation,
+                             int16_t x, int16_t y, int16_t w, int16_t h, F color)
+{
+    for (int16_t i = 0; i < w; i++) {
+        uint8_t * row = &data[(int32_t)line_size * ((rotation == 1) ? x + i : raw_height - 1 - x - i)];
+        int16_t   j   = 0;
+
+        // Physical column of the leftmost pixel of the pair starting at row j
+
+        auto pairColumn = [&](int16_t j) -> int16_t {
+            return (rotation == 1) ? raw_width - 2 - (y + j) : y + j;
+        };
+
+        auto single = [&](int16_t j) {
+            int16_t   px = (rotation == 1) ? raw_width - 1 - (y + j) : y + j;
+            uint8_t * b  = &row[px >> 1];
+            if (px & 1)
+                *b = (*b & 0xF0) | color(i, j, *b & 0x0F);
+            else
+                *b = (*b & 0x0F) | (color(i, j, *b >> 4) << 4);
+        };
+
+        if ((h > 1) && (pairColumn(0) & 1)) single(j++);
+
+        for (; j + 1 < h; j += 2) {
+            uint8_t * b = &row[pairColumn(j) >> 1];
+            uint8_t   d = *b;
+            if (rotation == 1)
+                *b = (color(i, j + 1, d >> 4) << 4) | color(i, j, d & 0x0F);
+            else
+                *b = (color(i, j, d >> 4) << 4) | color(i, j + 1, d & 0x0F);
+        }
+
+        if (j < h) single(j);
+    }
+}
+
+void Graphics::blitRotated(int16_t x, int16_t y, const uint8_t * src, int16_t stride, int16_t src_x, int16_t w, int16_t h,
+                           RasterOp op, bool lsb_first)
+{
+    uint8_t * data      = _partial->get_data();
+    int16_t   line_size = _partial->get_line_size();
+
+    // Work buffer: a reversed row (rotation 2), or 8 columns and a reversed
+    // one (rotations 1 and 3).
+
+    int16_t   bytes = (((rotation == 2) ? w : h) + 7) >> 3;
+    int32_t   size  = (rotation == 2) ? bytes : 9 * bytes;
+    uint8_t   local[256];
+    uint8_t * buffer = (size <= (int32_t)sizeof(local)) ? local : new uint8_t[size];
+
+    if (rotation == 2) {
+        int16_t pad = (bytes << 3) - w;
+
+        for (int16_t j = 0; j < h; j++, src += stride) {
+            for (int16_t k = 0; k < bytes; k++) {
+                buffer[bytes - 1 - k] = reversed[sourceByte(src, stride, src_x + (k << 3), lsb_first)];
+            }
+            blitRowLsb(op, &data[(int32_t)line_size * (HEIGHT - 1 - (y + j))], WIDTH - x - w, buffer, bytes, pad, w);
+        }
+    }
+    else {
+        uint8_t * rev = &buffer[8 * bytes];
+        int16_t   pad = (bytes << 3) - h;
+
+        for (int16_t c = 0; c < w; c += 8) {
+            int16_t count = (w - c < 8) ? w - c : 8;
+
+            // Column k of this band goes to buffer[k * bytes], top to bottom
+
+            for (int16_t r = 0; r < h; r += 8) {
+                uint64_t m = 0;
+                for (int16_t i = 0; (i < 8) && (r + i < h); i++) {
+                    m |= (uint64_t)sourceByte(&src[(int32_t)stride * (r + i)], stride, src_x + c, lsb_first) << (i << 3);
+                }
+                m = transpose8x8(m);
+                for (int16_t k = 0; k < count; k++) buffer[k * bytes + (r >> 3)] = m >> (k << 3);
+            }
+
+            for (int16_t k = 0; k < count; k++) {
+                int16_t col = x + c + k;
+                if (rotation == 3) {
+                    blitRowLsb(op, &data[(int32_t)line_size * (HEIGHT - 1 - col)], y, &buffer[k * bytes], bytes, 0, h);
+                }
+                else {
+                    reverseBits(rev, &buffer[k * bytes], bytes);
+                    blitRowLsb(op, &data[(int32_t)line_size * col], WIDTH - y - h, rev, bytes, pad, h);
+                }
+            }
+        }
+    }
+
+    if (buffer != local) delete [] buffer;
+}
+
+void Graphics::blit(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h, RasterOp op, bool lsb_first)
+{
+    blit(x, y, bitmap, (w + 7) >> 3, 0, 0, w, h, op, lsb_first);
+}
+
+void Graphics::blit(int16_t x, int16_t y, const uint8_t * bitmap, int16_t stride, int16_t src_x, int16_t src_y,
+                    int16_t w, int16_t h, RasterOp op, bool lsb_first)
+{
+    // Clip to the clipping rectangle
+
+    int16_t dx, dy;
+
+    if ((w <= 0) || (h <= 0) || !clipRect(x, y, w, h, dx, dy)) return;
+
+    src_x += dx;
+    src_y += dy;
+
+    const uint8_t * src = &bitmap[(int32_t)stride * src_y];
+
+    if (display_mode == DisplayMode::INKPLATE_1BIT) {
+        if (rotation != 0) {
+            blitRotated(x, y, src, stride, src_x, w, h, op, lsb_first);
+            return;
+        }
+
+        int16_t   line_size = _partial->get_line_size();
+        uint8_t * dst       = &_partial->get_data()[(int32_t)line_size * y];
+
+        switch (op) {
+            case RasterOp::OR:      blitRows<RasterOp::OR     >(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+            case RasterOp::AND:     blitRows<RasterOp::AND    >(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+            case RasterOp::XOR:     blitRows<RasterOp::XOR    >(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+            case RasterOp::NOT:     blitRows<RasterOp::NOT    >(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+            case RasterOp::AND_NOT: blitRows<RasterOp::AND_NOT>(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+            default:                blitRows<RasterOp::COPY   >(dst, line_size, x, src, stride, src_x, w, h, lsb_first); break;
+        }
+        return;
+    }
+
+    auto sourceBit = [&](int16_t i, int16_t j) -> bool {
+        const uint8_t * row = &src[(int32_t)stride * j];
+        int32_t         bit = src_x + i;
+        return lsb_first ? (row[bit >> 3] >> (bit & 7)) & 1 : (row[bit >> 3] << (bit & 7)) & 0x80;
+    };
+
+    if ((rotation == 1) || (rotation == 3)) {
+        writeNibblePairs(DMemory4Bit->get_data(), DMemory4Bit->get_line_size(), WIDTH, HEIGHT, rotation, x, y, w, h,
+                         [&](int16_t i, int16_t j, uint8_t d) -> uint8_t {
+                             return rasterOpGray(op, d, sourceBit(i, j));
+                         });
+        return;
+    }
+
+    withPixelSink([&](auto & sink) {
+        for (int16_t j = 0; j < h; j++) {
+            for (int16_t i = 0; i < w; i++) {
+                bool    s   = sourceBit(i, j);
+                uint8_t d   = sink.getPixel(x + i, y + j);
+
+                if (sink.mode == DisplayMode::INKPLATE_1BIT) {
+                    uint8_t v;
+                    switch (op) {
+                        case RasterOp::OR:      v = rasterOp<RasterOp::OR     >(d, s); break;
+                        case RasterOp::AND:     v = rasterOp<RasterOp::AND    >(d, s); break;
+                        case RasterOp::XOR:     v = rasterOp<RasterOp::XOR    >(d, s); break;
+                        case RasterOp::NOT:     v = rasterOp<RasterOp::NOT    >(d, s); break;
+                        case RasterOp::AND_NOT: v = rasterOp<RasterOp::AND_NOT>(d, s); break;
+                        default:                v = s;                                 break;
+                    }
+                    sink.writePixel(x + i, y + j, v & 1);
+                }
+                else {
+                    sink.writePixel(x + i, y + j, rasterOpGray(op, d, s));
+                }
+            }
+        }
+    });
+}
+
+void Graphics::writePixelBlock(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * colors)
+{
+    if (display_mode == DisplayMode::INKPLATE_1BIT) {
+
+        // Packed in bands of rows, then blitted
+
+        uint8_t packed[128];
+        int16_t stride = (w + 7) >> 3;
+        int16_t band   = sizeof(packed) / stride;
+
+        if (band == 0) {
+            for (int16_t j = 0; j < h; j++) writePixelRow(x, y + j, &colors[(int32_t)w * j], w);
+            return;
+        }
+
+        for (int16_t j = 0; j < h; j += band) {
+            int16_t rows = (h - j < band) ? h - j : band;
+            memset(packed, 0, stride * rows);
+            for (int16_t jj = 0; jj < rows; jj++) {
+                const uint8_t * c = &colors[(int32_t)w * (j + jj)];
+                uint8_t       * p = &packed[stride * jj];
+                for (int16_t i = 0; i < w; i++) {
+                    if (c[i]) p[i >> 3] |= 1 << (i & 7);
+                }
+            }
+            blit(x, y + j, packed, stride, 0, 0, w, rows, RasterOp::COPY, true);
+        }
+        return;
+    }
+
+    if ((rotation == 1) || (rotation == 3)) {
+        int16_t stride = w, sx, sy;
+
+        if ((w <= 0) || (h <= 0) || !clipRect(x, y, w, h, sx, sy)) return;
+
+        colors = &colors[(int32_t)stride * sy + sx];
+        writeNibblePairs(DMemory4Bit->get_data(), DMemory4Bit->get_line_size(), WIDTH, HEIGHT, rotation, x, y, w, h,
+                         [&](int16_t i, int16_t j, uint8_t) -> uint8_t { return colors[(int32_t)stride * j + i] & 7; });
+        return;
+    }
+
+    for (int16_t j = 0; j < h; j++) writePixelRow(x, y + j, &colors[(int32_t)w * j], w);
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Offscreen canvas compositing. A GFXcanvas1 goes through the blit engine,
+// GFXcanvas8 and GFXcanvas16 canvases are written a row (or a block) at a
+// time, cut in runs around the transparent color if any. Rows outside of the
+// clipping rectangle are skipped. A canvas with a
+// rotation is read through its getPixel() method, one row at a time.
+
+#include "graphics.hpp"
+
+#include <cstring>
+
+void Graphics::drawCanvas(int16_t x, int16_t y, const GFXcanvas1 & canvas, RasterOp op)
+{
+    const uint8_t * buffer = canvas.getBuffer();
+    int16_t         w      = canvas.width();
+    int16_t         h      = canvas.height();
+
+    if (buffer == nullptr) return;
+
+    if (canvas.getRotation() == 0)
+    {
+        blit(x, y, buffer, (w + 7) >> 3, 0, 0, w, h, op);
+        return;
+    }
+
+    int16_t   stride = (w + 7) >> 3;
+    uint8_t * row    = new uint8_t[stride];
+
+    for (int16_t j = 0; j < h; j++)
+    {
+        if ((y + j < clip_y0) || (y + j > clip_y1)) continue;
+
+        memset(row, 0, stride);
+        for (int16_t i = 0; i < w; i++)
+        {
+            if (canvas.getPixel(i, j)) row[i >> 3] |= 0x80 >> (i & 7);
+        }
+        blit(x, y + j, row, stride, 0, 0, w, 1, op);
+    }
+
+    delete [] row;
+}
+
+void Graphics::drawCanvas(int16_t x, int16_t y, const GFXcanvas8 & canvas, int16_t transparent)
+{
+    const uint8_t * buffer = canvas.getBuffer();
+    int16_t         w      = canvas.width();
+    int16_t         h      = canvas.height();
+
+    if (buffer == nullptr) return;
+
+    if ((canvas.getRotation() == 0) && (transparent < 0))
+    {
+        writePixelBlock(x, y, w, h, buffer);
+        return;
+    }
+
+    uint8_t * row = (canvas.getRotation() != 0) ? new uint8_t[w] : nullptr;
+
+    for (int16_t j = 0; j < h; j++)
+    {
+        if ((y + j < clip_y0) || (y + j > clip_y1)) continue;
+
+        const uint8_t * colors = &buffer[(int32_t)w * j];
+        if (row != nullptr)
+        {
+            for (int16_t i = 0; i < w; i++) row[i] = canvas.getPixel(i, j);
+            colors = row;
+        }
+
+        for (int16_t i = 0; i < w;)
+        {
+            while ((i < w) && (colors[i] == transparent)) i++;
+            int16_t start = i;
+            while ((i < w) && (colors[i] != transparent)) i++;
+            if (i > start) writePixelRow(x + start, y + j, &colors[start], i - start);
+        }
+    }
+
+    if (row != nullptr) delete [] row;
+}
+
+void Graphics::drawCanvas(int16_t x, int16_t y, const GFXcanvas16 & canvas, int32_t transparent)
+{
+    const uint16_t * buffer = canvas.getBuffer();
+    int16_t          w      = canvas.width();
+    int16_t          h      = canvas.height();
+
+    if (buffer == nullptr) return;
+
+    // RGB565 colors are converted the same way as JPEG pixels
+
+    bool       one_bit = display_mode == DisplayMode::INKPLATE_1BIT;
+    uint8_t  * colors  = new uint8_t[w];
+    uint16_t * row     = (canvas.getRotation() != 0) ? new uint16_t[w] : nullptr;
+
+    for (int16_t j = 0; j < h; j++)
+    {
+        if ((y + j < clip_y0) || (y + j > clip_y1)) continue;
+
+        const uint16_t * rgb = &buffer[(int32_t)w * j];
+        if (row != nullptr)
+        {
+            for (int16_t i = 0; i < w; i++) row[i] = canvas.getPixel(i, j);
+            rgb = row;
+        }
+
+        for (int16_t i = 0; i < w;)
+        {
+            while ((i < w) && (rgb[i] == transparent)) i++;
+            int16_t start = i;
+            for (; (i < w) && (rgb[i] != transparent); i++)
+            {
+                uint8_t val = rgb3Bit(red(rgb[i]), green(rgb[i]), blue(rgb[i]));
+                colors[i]   = one_bit ? (~val >> 2) & 1 : val;
+            }
+            if (i > start) writePixelRow(x + start, y + j, &colors[start], i - start);
+        }
+    }
+
+    if (row != nullptr) delete [] row;
+    delete [] colors;
+}
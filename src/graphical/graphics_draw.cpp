@@ -0,0 +1,299 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Pixel oriented primitives. These are the Adafruit_GFX algorithms, with
+// their inner loops writing through a PixelSink selected once per call
+// instead of the virtual writePixel() method.
+
+#include "graphics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+void Graphics::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    int16_t dx, dy;
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+
+    int16_t err = dx >> 1;
+    int16_t ystep;
+
+    if (y0 < y1)
+        ystep = 1;
+    else
+        ystep = -1;
+
+    withPixelSink([&](auto & sink) {
+        for (; x0 <= x1; x0++)
+        {
+            if (steep)
+                sink.drawPixel(y0, x0, color);
+            else
+                sink.drawPixel(x0, y0, color);
+            err -= dy;
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    });
+}
+
+void Graphics::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+    withPixelSink([&](auto & sink) {
+        int16_t f     = 1 - r;
+        int16_t ddF_x = 1;
+        int16_t ddF_y = -2 * r;
+        int16_t x     = 0;
+        int16_t y     = r;
+
+        sink.drawPixel(x0, y0 + r, color);
+        sink.drawPixel(x0, y0 - r, color);
+        sink.drawPixel(x0 + r, y0, color);
+        sink.drawPixel(x0 - r, y0, color);
+
+        while (x < y)
+        {
+            if (f >= 0)
+            {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+
+            sink.drawPixel(x0 + x, y0 + y, color);
+            sink.drawPixel(x0 - x, y0 + y, color);
+            sink.drawPixel(x0 + x, y0 - y, color);
+            sink.drawPixel(x0 - x, y0 - y, color);
+            sink.drawPixel(x0 + y, y0 + x, color);
+            sink.drawPixel(x0 - y, y0 + x, color);
+            sink.drawPixel(x0 + y, y0 - x, color);
+            sink.drawPixel(x0 - y, y0 - x, color);
+        }
+    });
+}
+
+void Graphics::drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color)
+{
+    withPixelSink([&](auto & sink) {
+        int16_t f     = 1 - r;
+        int16_t ddF_x = 1;
+        int16_t ddF_y = -2 * r;
+        int16_t x     = 0;
+        int16_t y     = r;
+
+        while (x < y)
+        {
+            if (f >= 0)
+            {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+
+            if (cornername & 0x4)
+            {
+                sink.drawPixel(x0 + x, y0 + y, color);
+                sink.drawPixel(x0 + y, y0 + x, color);
+            }
+            if (cornername & 0x2)
+            {
+                sink.drawPixel(x0 + x, y0 - y, color);
+                sink.drawPixel(x0 + y, y0 - x, color);
+            }
+            if (cornername & 0x8)
+            {
+                sink.drawPixel(x0 - y, y0 + x, color);
+                sink.drawPixel(x0 - x, y0 + y, color);
+            }
+            if (cornername & 0x1)
+            {
+                sink.drawPixel(x0 - y, y0 - x, color);
+                sink.drawPixel(x0 - x, y0 - y, color);
+            }
+        }
+    });
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+{
+    if (display_mode == DisplayMode::INKPLATE_1BIT)
+    {
+        blit(x, y, bitmap, w, h, color ? RasterOp::OR : RasterOp::AND_NOT);
+        return;
+    }
+
+    int16_t byteWidth = (w + 7) >> 3; // Bitmap scanline pad = whole byte
+
+    withPixelSink([&](auto & sink) {
+        for (int16_t j = 0; j < h; j++)
+        {
+            if ((y + j < sink.clipTop()) || (y + j > sink.clipBottom())) continue;
+
+            const uint8_t * p    = &bitmap[j * byteWidth];
+            uint8_t         byte = 0;
+
+            for (int16_t i = 0; i < w; i++)
+            {
+                if (i & 7)
+                    byte <<= 1;
+                else
+                    byte = *p++;
+                if (byte & 0x80)
+                    sink.drawPixel(x + i, y + j, color);
+            }
+        }
+    });
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg)
+{
+    if (display_mode == DisplayMode::INKPLATE_1BIT)
+    {
+        if ((color != 0) == (bg != 0))
+            writeFillRect(x, y, w, h, color);
+        else
+            blit(x, y, bitmap, w, h, color ? RasterOp::COPY : RasterOp::NOT);
+        return;
+    }
+
+    int16_t byteWidth = (w + 7) >> 3; // Bitmap scanline pad = whole byte
+
+    withPixelSink([&](auto & sink) {
+        for (int16_t j = 0; j < h; j++)
+        {
+            if ((y + j < sink.clipTop()) || (y + j > sink.clipBottom())) continue;
+
+            const uint8_t * p    = &bitmap[j * byteWidth];
+            uint8_t         byte = 0;
+
+            for (int16_t i = 0; i < w; i++)
+            {
+                if (i & 7)
+                    byte <<= 1;
+                else
+                    byte = *p++;
+                sink.drawPixel(x + i, y + j, (byte & 0x80) ? color : bg);
+            }
+        }
+    });
+}
+
+void Graphics::writePixelRow(int16_t x, int16_t y, const uint8_t * colors, int16_t count)
+{
+    withPixelSink([&](auto & sink) {
+        sink.writeRow(x, y, colors, count);
+    });
+}
+
+// 4 bits per pixel source bytes (two pixels, high nibble first) to frame
+// buffer bytes: each level is divided by 2.
+
+static const uint8_t nibbleRemap[256] = {
+    0x00, 0x00, 0x01, 0x01, 0x02, 0x02, 0x03, 0x03, 0x04, 0x04, 0x05, 0x05, 0x06, 0x06, 0x07, 0x07,
+    0x00, 0x00, 0x01, 0x01, 0x02, 0x02, 0x03, 0x03, 0x04, 0x04, 0x05, 0x05, 0x06, 0x06, 0x07, 0x07,
+    0x10, 0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x13, 0x14, 0x14, 0x15, 0x15, 0x16, 0x16, 0x17, 0x17,
+    0x10, 0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x13, 0x14, 0x14, 0x15, 0x15, 0x16, 0x16, 0x17, 0x17,
+    0x20, 0x20, 0x21, 0x21, 0x22, 0x22, 0x23, 0x23, 0x24, 0x24, 0x25, 0x25, 0x26, 0x26, 0x27, 0x27,
+    0x20, 0x20, 0x21, 0x21, 0x22, 0x22, 0x23, 0x23, 0x24, 0x24, 0x25, 0x25, 0x26, 0x26, 0x27, 0x27,
+    0x30, 0x30, 0x31, 0x31, 0x32, 0x32, 0x33, 0x33, 0x34, 0x34, 0x35, 0x35, 0x36, 0x36, 0x37, 0x37,
+    0x30, 0x30, 0x31, 0x31, 0x32, 0x32, 0x33, 0x33, 0x34, 0x34, 0x35, 0x35, 0x36, 0x36, 0x37, 0x37,
+    0x40, 0x40, 0x41, 0x41, 0x42, 0x42, 0x43, 0x43, 0x44, 0x44, 0x45, 0x45, 0x46, 0x46, 0x47, 0x47,
+    0x40, 0x40, 0x41, 0x41, 0x42, 0x42, 0x43, 0x43, 0x44, 0x44, 0x45, 0x45, 0x46, 0x46, 0x47, 0x47,
+    0x50, 0x50, 0x51, 0x51, 0x52, 0x52, 0x53, 0x53, 0x54, 0x54, 0x55, 0x55, 0x56, 0x56, 0x57, 0x57,
+    0x50, 0x50, 0x51, 0x51, 0x52, 0x52, 0x53, 0x53, 0x54, 0x54, 0x55, 0x55, 0x56, 0x56, 0x57, 0x57,
+    0x60, 0x60, 0x61, 0x61, 0x62, 0x62, 0x63, 0x63, 0x64, 0x64, 0x65, 0x65, 0x66, 0x66, 0x67, 0x67,
+    0x60, 0x60, 0x61, 0x61, 0x62, 0x62, 0x63, 0x63, 0x64, 0x64, 0x65, 0x65, 0x66, 0x66, 0x67, 0x67,
+    0x70, 0x70, 0x71, 0x71, 0x72, 0x72, 0x73, 0x73, 0x74, 0x74, 0x75, 0x75, 0x76, 0x76, 0x77, 0x77,
+    0x70, 0x70, 0x71, 0x71, 0x72, 0x72, 0x73, 0x73, 0x74, 0x74, 0x75, 0x75, 0x76, 0x76, 0x77, 0x77
+};
+
+void Graphics::writeNibbleRow(int16_t x, int16_t y, const uint8_t * src, int16_t w)
+{
+    if ((y < clip_y0) || (y > clip_y1)) return;
+
+    int16_t first = (x < clip_x0) ? clip_x0 - x : 0;
+    int16_t last  = (x + w - 1 > clip_x1) ? clip_x1 - x : w - 1;
+
+    if (first > last) return;
+
+    auto level = [&](int16_t i) -> uint8_t {
+        return (i & 1) ? (nibbleRemap[src[i >> 1]] & 0x0F) : (nibbleRemap[src[i >> 1]] >> 4);
+    };
+
+    if (rotation != 0)
+    {
+        withPixelSink([&](auto & sink) {
+            for (int16_t i = first; i <= last; i++) sink.writePixel(x + i, y, level(i));
+        });
+        return;
+    }
+
+    uint8_t * dst = &DMemory4Bit->get_data()[(int32_t)DMemory4Bit->get_line_size() * y];
+    int16_t   i   = first;
+
+    // Leading pixel in the low nibble of a frame buffer byte
+
+    if ((x + i) & 1)
+    {
+        uint8_t * d = &dst[(x + i) >> 1];
+        *d = (*d & 0xF0) | level(i);
+        i++;
+    }
+
+    // Whole frame buffer bytes. When the source nibbles are at the same
+    // position, this is a byte copy through the remap table. Otherwise,
+    // each byte gets the low nibble of a source byte and the high nibble of
+    // the next one.
+
+    uint8_t *       d = &dst[(x + i) >> 1];
+    const uint8_t * s = &src[i >> 1];
+    int16_t         n = (last - i + 1) >> 1;
+
+    if ((i & 1) == 0)
+    {
+        for (int16_t k = 0; k < n; k++) d[k] = nibbleRemap[s[k]];
+    }
+    else
+    {
+        uint8_t prev = nibbleRemap[s[0]];
+        for (int16_t k = 0; k < n; k++)
+        {
+            uint8_t next = nibbleRemap[s[k + 1]];
+            d[k] = (prev << 4) | (next >> 4);
+            prev = next;
+        }
+    }
+    i += n << 1;
+
+    // Trailing pixel in the high nibble
+
+    if (i <= last)
+    {
+        d = &dst[(x + i) >> 1];
+        *d = (*d & 0x0F) | (level(i) << 4);
+    }
+}
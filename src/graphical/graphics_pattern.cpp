@@ -0,0 +1,89 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Pattern (stipple) fills. The shape primitives are run with a pattern
+// installed for the span kernels (see graphics_span.cpp), which apply it a
+// whole frame buffer byte at a time in 1-bit mode.
+
+#include "graphics.hpp"
+
+static const uint8_t bayer[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
+void Graphics::bayerPattern(uint8_t level, uint8_t pattern[8])
+{
+    // level is the number of set pixels out of 64
+
+    for (int y = 0; y < 8; y++) {
+        uint8_t row = 0;
+        for (int x = 0; x < 8; x++) {
+            if (bayer[y][x] < level) row |= 1 << x;
+        }
+        pattern[y] = row;
+    }
+}
+
+void Graphics::fillRectPattern(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t pattern[8], uint16_t color, int16_t bg)
+{
+    fill_pattern    = pattern;
+    fill_pattern_bg = bg;
+    writeFillRect(x, y, w, h, color);
+    fill_pattern    = nullptr;
+}
+
+void Graphics::fillCirclePattern(int16_t x0, int16_t y0, int16_t r, const uint8_t pattern[8], uint16_t color, int16_t bg)
+{
+    fill_pattern    = pattern;
+    fill_pattern_bg = bg;
+    fillCircle(x0, y0, r, color);
+    fill_pattern    = nullptr;
+}
+
+void Graphics::fillPolygonPattern(int *x, int *y, int n, const uint8_t pattern[8], uint16_t color, int16_t bg)
+{
+    // The outline is not drawn: it would be solid.
+
+    fill_pattern    = pattern;
+    fill_pattern_bg = bg;
+    fillPolygonSpans(x, y, n, color);
+    fill_pattern    = nullptr;
+}
+
+void Graphics::fillGradientRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t level0, uint8_t level1, bool vertical,
+                                uint16_t color, uint16_t bg)
+{
+    // The rectangle is cut in bands of constant Bayer level, from level0
+    // (top or left side) to level1 (bottom or right side).
+
+    int16_t size = vertical ? h : w;
+    if (size <= 0) return;
+
+    if (level0 > 64) level0 = 64;
+    if (level1 > 64) level1 = 64;
+
+    uint8_t pattern[8];
+    int16_t start = 0;
+    int     level = level0;
+
+    for (int16_t i = 1; i <= size; i++) {
+        int next = (i < size) ? level0 + ((level1 - level0) * i) / (size > 1 ? size - 1 : 1) : -1;
+        if (next != level) {
+            bayerPattern(level, pattern);
+            if (vertical)
+                fillRectPattern(x, y + start, w, i - start, pattern, color, bg);
+            else
+                fillRectPattern(x + start, y, i - start, h, pattern, color, bg);
+            start = i;
+            level = next;
+        }
+    }
+}
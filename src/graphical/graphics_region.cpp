@@ -0,0 +1,187 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Saving and restoring rectangles of the frame buffer. The frame buffer
+// bytes covering the rectangle are copied row by row, optionally compressed
+// with the PackBits run length encoding: a control byte n in 0..127 is
+// followed by n + 1 literal bytes, a control byte n in 129..255 by a single
+// byte to be repeated 257 - n times. Menus and popups are mostly uniform
+// areas and compress well.
+
+#include "graphics.hpp"
+
+#include <cstring>
+
+static uint32_t packBits(const uint8_t * src, uint32_t n, uint8_t * dst)
+{
+    uint32_t i = 0, o = 0;
+
+    while (i < n) {
+        uint32_t run = 1;
+        while ((i + run < n) && (run < 128) && (src[i + run] == src[i])) run++;
+
+        if (run > 1) {
+            dst[o++] = 257 - run;
+            dst[o++] = src[i];
+            i += run;
+        }
+        else {
+            // Literals, up to the next run of at least 3 bytes. Shorter runs
+            // would cost more than they save, and the compressed size would
+            // no longer be bound by n + n / 128 + 1.
+
+            uint32_t start = i++;
+            while ((i < n) && ((i - start) < 128) &&
+                   !((i + 2 < n) && (src[i] == src[i + 1]) && (src[i] == src[i + 2]))) i++;
+            dst[o++] = i - start - 1;
+            memcpy(&dst[o], &src[start], i - start);
+            o += i - start;
+        }
+    }
+
+    return o;
+}
+
+// Decoding is done a row at a time, the state being kept between rows
+
+struct Unpacker {
+    const uint8_t * p;
+    uint16_t        count;   // Bytes left in the current packet
+    bool            repeat;
+
+    void unpack(uint8_t * dst, int16_t n) {
+        while (n > 0) {
+            if (count == 0) {
+                uint8_t c = *p++;
+                if (c == 128) continue;
+                repeat = c > 128;
+                count  = repeat ? 257 - c : c + 1;
+            }
+            int16_t k = (count < n) ? count : n;
+            if (repeat)
+                memset(dst, *p, k);
+            else {
+                memcpy(dst, p, k);
+                p += k;
+            }
+            dst   += k;
+            n     -= k;
+            count -= k;
+            if (repeat && (count == 0)) p++;
+        }
+    }
+};
+
+SavedRegion * Graphics::saveRegion(int16_t x, int16_t y, int16_t w, int16_t h, bool compress)
+{
+    // Clipped to the screen, not to the clipping rectangle
+
+    int32_t x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > _width ) x1 = _width;
+    if (y1 > _height) y1 = _height;
+
+    if ((x >= x1) || (y >= y1)) return nullptr;
+
+    SavedRegion * region = new SavedRegion;
+
+    region->mode = display_mode;
+    region->rect = { x, y, (int16_t)(x1 - x), (int16_t)(y1 - y) };
+    region->x    = x;
+    region->y    = y;
+    region->w    = x1 - x;
+    region->h    = y1 - y;
+
+    logicalToPhysical(region->x, region->y, region->w, region->h);
+
+    FrameBuffer * frame_buffer = (display_mode == DisplayMode::INKPLATE_1BIT) ? (FrameBuffer *)_partial : (FrameBuffer *)DMemory4Bit;
+    uint8_t       shift        = (display_mode == DisplayMode::INKPLATE_1BIT) ? 3 : 1;
+    int16_t       line_size    = frame_buffer->get_line_size();
+
+    region->first_byte = region->x >> shift;
+    region->row_bytes  = ((region->x + region->w - 1) >> shift) - region->first_byte + 1;
+    region->compressed = compress;
+
+    const uint8_t * src  = &frame_buffer->get_data()[(int32_t)line_size * region->y + region->first_byte];
+    uint32_t        size = (uint32_t)region->row_bytes * region->h;
+
+    if (!compress) {
+        region->data      = new uint8_t[size];
+        region->data_size = size;
+        for (int16_t j = 0; j < region->h; j++, src += line_size) {
+            memcpy(&region->data[(uint32_t)region->row_bytes * j], src, region->row_bytes);
+        }
+        return region;
+    }
+
+    // The rows are gathered to be compressed as a single stream, then the
+    // result is moved to a buffer of the right size.
+
+    uint8_t * raw    = new uint8_t[size];
+    uint8_t * packed = new uint8_t[size + (size >> 7) + 1];
+
+    for (int16_t j = 0; j < region->h; j++, src += line_size) {
+        memcpy(&raw[(uint32_t)region->row_bytes * j], src, region->row_bytes);
+    }
+
+    region->data_size = packBits(raw, size, packed);
+    region->data      = new uint8_t[region->data_size];
+    memcpy(region->data, packed, region->data_size);
+
+    delete [] packed;
+    delete [] raw;
+
+    return region;
+}
+
+Rect Graphics::restoreRegion(const SavedRegion & region)
+{
+    if (region.mode != display_mode) return { 0, 0, 0, 0 };
+
+    FrameBuffer * frame_buffer = (display_mode == DisplayMode::INKPLATE_1BIT) ? (FrameBuffer *)_partial : (FrameBuffer *)DMemory4Bit;
+    int16_t       line_size    = frame_buffer->get_line_size();
+    uint8_t     * dst          = &frame_buffer->get_data()[(int32_t)line_size * region.y + region.first_byte];
+    int16_t       last         = region.x + region.w - 1;
+    int16_t       n            = region.row_bytes;
+
+    // Pixels of the first and last bytes that belong to the rectangle
+
+    uint8_t first_mask, last_mask;
+
+    if (display_mode == DisplayMode::INKPLATE_1BIT) {
+        first_mask = 0xFF << (region.x & 7);
+        last_mask  = 0xFF >> (7 - (last & 7));
+    }
+    else {
+        first_mask = (region.x & 1) ? 0x0F : 0xFF;
+        last_mask  = (last     & 1) ? 0xFF : 0xF0;
+    }
+    if (n == 1) first_mask &= last_mask;
+
+    Unpacker  unpacker = { region.data, 0, false };
+    uint8_t * row      = region.compressed ? new uint8_t[n] : nullptr;
+
+    for (int16_t j = 0; j < region.h; j++, dst += line_size) {
+        const uint8_t * src;
+
+        if (row != nullptr) {
+            unpacker.unpack(row, n);
+            src = row;
+        }
+        else
+            src = &region.data[(uint32_t)n * j];
+
+        dst[0] = (dst[0] & ~first_mask) | (src[0] & first_mask);
+        if (n > 1) {
+            memcpy(&dst[1], &src[1], n - 2);
+            dst[n - 1] = (dst[n - 1] & ~last_mask) | (src[n - 1] & last_mask);
+        }
+    }
+
+    if (row != nullptr) delete [] row;
+
+    return region.rect;
+}
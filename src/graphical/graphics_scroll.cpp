@@ -0,0 +1,160 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Moving the content of a rectangle in place, for terminal, log or ticker
+// like screens. The move is done in the frame buffer orientation: rows are
+// copied with memmove() when they only move vertically, and are otherwise
+// shifted a byte at a time from a copy of the source row (bit shifts in
+// 1-bit mode, nibble shifts in 3-bit mode).
+
+#include "graphics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+Rect Graphics::scrollRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dy)
+{
+    return moveRegion(x, y, w, h, 0, dy);
+}
+
+Rect Graphics::shiftRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx)
+{
+    return moveRegion(x, y, w, h, dx, 0);
+}
+
+Rect Graphics::moveRegion(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx, int16_t dy)
+{
+    int16_t cx, cy;
+
+    if ((w <= 0) || (h <= 0) || !clipRect(x, y, w, h, cx, cy)) return { 0, 0, 0, 0 };
+
+    // The revealed strip
+
+    Rect revealed;
+
+    if (dx > 0)
+        revealed = { x, y, std::min(dx, w), h };
+    else if (dx < 0)
+        revealed = { (int16_t)(x + w - std::min<int16_t>(-dx, w)), y, std::min<int16_t>(-dx, w), h };
+    else if (dy > 0)
+        revealed = { x, y, w, std::min(dy, h) };
+    else if (dy < 0)
+        revealed = { x, (int16_t)(y + h - std::min<int16_t>(-dy, h)), w, std::min<int16_t>(-dy, h) };
+    else
+        return { 0, 0, 0, 0 };
+
+    if ((abs(dx) >= w) || (abs(dy) >= h)) return revealed;
+
+    // Physical rectangle and displacement
+
+    int16_t px = x, py = y, pw = w, ph = h, pdx, pdy;
+
+    logicalToPhysical(px, py, pw, ph);
+
+    switch (rotation)
+    {
+    case 1:  pdx = -dy; pdy =  dx; break;
+    case 2:  pdx = -dx; pdy = -dy; break;
+    case 3:  pdx =  dy; pdy = -dx; break;
+    default: pdx =  dx; pdy =  dy; break;
+    }
+
+    bool          one_bit      = display_mode == DisplayMode::INKPLATE_1BIT;
+    FrameBuffer * frame_buffer = one_bit ? (FrameBuffer *)_partial : (FrameBuffer *)DMemory4Bit;
+    uint8_t       shift        = one_bit ? 3 : 1;
+    int32_t       line_size    = frame_buffer->get_line_size();
+
+    // Destination pixels of each row, the others being revealed
+
+    int16_t first = px + std::max<int16_t>(pdx, 0);
+    int16_t last  = px + pw - 1 + std::min<int16_t>(pdx, 0);
+
+    // Destination rows, in an order that reads each source row before it
+    // is overwritten
+
+    int16_t first_row = py + std::max<int16_t>(pdy, 0);
+    int16_t last_row  = py + ph - 1 + std::min<int16_t>(pdy, 0);
+    int16_t step      = (pdy > 0) ? -1 : 1;
+    int16_t row_count = last_row - first_row + 1;
+    int16_t r         = (pdy > 0) ? last_row : first_row;
+
+    int16_t b0 = first >> shift;
+    int16_t b1 = last  >> shift;
+    int16_t n  = b1 - b0 + 1;
+
+    uint8_t first_mask, last_mask;
+
+    if (one_bit) {
+        first_mask = 0xFF << (first & 7);
+        last_mask  = 0xFF >> (7 - (last & 7));
+    }
+    else {
+        first_mask = (first & 1) ? 0x0F : 0xFF;
+        last_mask  = (last  & 1) ? 0xFF : 0xF0;
+    }
+    if (n == 1) first_mask &= last_mask;
+
+    uint8_t * data = frame_buffer->get_data();
+
+    if (pdx == 0) {
+        for (int16_t k = 0; k < row_count; k++, r += step) {
+            uint8_t       * dst = &data[line_size * r + b0];
+            const uint8_t * src = &data[line_size * (r - pdy) + b0];
+
+            dst[0] = (dst[0] & ~first_mask) | (src[0] & first_mask);
+            if (n > 1) {
+                memmove(&dst[1], &src[1], n - 2);
+                dst[n - 1] = (dst[n - 1] & ~last_mask) | (src[n - 1] & last_mask);
+            }
+        }
+        return revealed;
+    }
+
+    // The source row bytes are copied with a zero byte on each side, as the
+    // shifted bytes at the edges of the row may read past the source pixels
+    // (these bits are masked out).
+
+    int16_t   s0   = (first - pdx) >> shift;
+    int16_t   sn   = ((last - pdx) >> shift) - s0 + 1;
+    uint8_t * copy = new uint8_t[sn + 2];
+
+    copy[0] = copy[sn + 1] = 0;
+
+    for (int16_t k = 0; k < row_count; k++, r += step) {
+        uint8_t * dst = &data[line_size * r + b0];
+
+        memcpy(&copy[1], &data[line_size * (r - pdy) + s0], sn);
+
+        for (int16_t i = 0; i < n; i++) {
+            uint8_t value;
+
+            if (one_bit) {
+                // Bits of the destination byte, pixel 0 being the least
+                // significant one, starting at this source pixel (relative
+                // to the copy)
+
+                int16_t pos = ((b0 + i) << 3) - pdx - (s0 << 3) + 8;
+                uint8_t off = pos & 7;
+                int16_t idx = pos >> 3;
+
+                value = off ? (copy[idx] >> off) | (copy[idx + 1] << (8 - off)) : copy[idx];
+            }
+            else {
+                int16_t pos = ((b0 + i) << 1) - pdx - (s0 << 1) + 2;
+                int16_t idx = pos >> 1;
+
+                value = (pos & 1) ? (copy[idx] << 4) | (copy[idx + 1] >> 4) : copy[idx];
+            }
+
+            uint8_t mask = (i == 0) ? first_mask : ((i == n - 1) ? last_mask : 0xFF);
+
+            dst[i] = (dst[i] & ~mask) | (value & mask);
+        }
+    }
+
+    delete [] copy;
+
+    return revealed;
+}
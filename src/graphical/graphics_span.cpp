@@ -0,0 +1,237 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Span based fill kernels. A rectangle in logical (rotated) coordinates is
+// always a rectangle in the physical frame buffer, so all fills are clipped
+// once, translated to physical coordinates, and then written a row at a
+// time (or a column at a time for single pixel wide physical rectangles)
+// directly into the selected frame buffer.
+
+#include "graphics.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void Graphics::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, w, h, color);
+}
+
+void Graphics::fillScreen(uint16_t color)
+{
+    writeFillRect(0, 0, _width, _height, color);
+}
+
+void Graphics::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void Graphics::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void Graphics::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void Graphics::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void Graphics::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (!toPhysicalRect(x, y, w, h)) return;
+
+    if (fill_pattern != nullptr) {
+        if (display_mode == DisplayMode::INKPLATE_1BIT)
+            fillPhysicalRectPattern1Bit(x, y, w, h, color);
+        else
+            fillPhysicalRectPattern3Bit(x, y, w, h, color);
+    }
+    else if (display_mode == DisplayMode::INKPLATE_1BIT)
+        fillPhysicalRect1Bit(x, y, w, h, color);
+    else
+        fillPhysicalRect3Bit(x, y, w, h, color);
+}
+
+bool Graphics::toPhysicalRect(int16_t & x, int16_t & y, int16_t & w, int16_t & h)
+{
+    if ((w <= 0) || (h <= 0)) return false;
+
+    // Clip to the clipping rectangle
+
+    int16_t dx, dy;
+
+    if (!clipRect(x, y, w, h, dx, dy)) return false;
+
+    logicalToPhysical(x, y, w, h);
+
+    return true;
+}
+
+void Graphics::logicalToPhysical(int16_t & x, int16_t & y, int16_t & w, int16_t & h)
+{
+    int16_t x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+
+    switch (rotation)
+    {
+    case 1:
+        x = WIDTH - y1 - 1;
+        y = x0;
+        std::swap(w, h);
+        break;
+    case 2:
+        x = WIDTH  - x1 - 1;
+        y = HEIGHT - y1 - 1;
+        break;
+    case 3:
+        x = y0;
+        y = HEIGHT - x1 - 1;
+        std::swap(w, h);
+        break;
+    default:
+        x = x0;
+        y = y0;
+        break;
+    }
+}
+
+void Graphics::fillPhysicalRect1Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t   line_size = _partial->get_line_size();
+    uint8_t * row       = &_partial->get_data()[line_size * y];
+
+    int16_t x1 = x + w - 1;
+    int16_t b0 = x >> 3, b1 = x1 >> 3;
+
+    // Pixel 0 of a byte is its least significant bit
+
+    uint8_t first_mask = 0xFF << (x & 7);
+    uint8_t last_mask  = 0xFF >> (7 - (x1 & 7));
+
+    if (w == 1) {
+        // Column walk
+        uint8_t * p = row + b0;
+        if (color) {
+            for (int16_t i = 0; i < h; i++, p += line_size) *p |=  first_mask & last_mask;
+        }
+        else {
+            for (int16_t i = 0; i < h; i++, p += line_size) *p &= ~(first_mask & last_mask);
+        }
+        return;
+    }
+
+    if (b0 == b1) first_mask &= last_mask;
+
+    uint8_t value  = color ? 0xFF : 0x00;
+    int16_t middle = b1 - b0 - 1;
+
+    for (int16_t i = 0; i < h; i++, row += line_size) {
+        row[b0] = (row[b0] & ~first_mask) | (value & first_mask);
+        if (b0 != b1) {
+            if (middle > 0) memset(&row[b0 + 1], value, middle);
+            row[b1] = (row[b1] & ~last_mask) | (value & last_mask);
+        }
+    }
+}
+
+void Graphics::fillPhysicalRect3Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t   line_size = DMemory4Bit->get_line_size();
+    uint8_t * row       = &DMemory4Bit->get_data()[line_size * y];
+
+    color &= 7;
+
+    // Even pixels are in the high nibble, odd ones in the low nibble. A span
+    // is made of an optional odd leading pixel, a run of complete byte
+    // pairs and an optional even trailing pixel.
+
+    int16_t x0 = x, x1 = x + w - 1;
+    bool    lead  = x0 & 1;
+    bool    trail = !(x1 & 1);
+
+    if (lead ) x0++;
+    if (trail) x1--;
+
+    uint8_t value = (color << 4) | color;
+    int16_t count = (x1 >= x0) ? ((x1 - x0 + 1) >> 1) : 0;
+
+    if (w == 1) {
+        // Column walk
+        uint8_t * p = row + (x >> 1);
+        if (lead) {
+            for (int16_t i = 0; i < h; i++, p += line_size) *p = (*p & 0xF0) | color;
+        }
+        else {
+            for (int16_t i = 0; i < h; i++, p += line_size) *p = (*p & 0x0F) | (color << 4);
+        }
+        return;
+    }
+
+    for (int16_t i = 0; i < h; i++, row += line_size) {
+        if (lead ) row[x >> 1]      = (row[x >> 1]      & 0xF0) | color;
+        if (count) memset(&row[x0 >> 1], value, count);
+        if (trail) row[(x + w - 1) >> 1] = (row[(x + w - 1) >> 1] & 0x0F) | (color << 4);
+    }
+}
+
+void Graphics::fillPhysicalRectPattern1Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t   line_size = _partial->get_line_size();
+    uint8_t * row       = &_partial->get_data()[line_size * y];
+
+    int16_t x1 = x + w - 1;
+    int16_t b0 = x >> 3, b1 = x1 >> 3;
+
+    uint8_t first_mask = 0xFF << (x & 7);
+    uint8_t last_mask  = 0xFF >> (7 - (x1 & 7));
+
+    if (b0 == b1) first_mask &= last_mask;
+
+    // The pattern row bits line up with the frame buffer bytes: for each
+    // byte, the bits to set and the bits to clear are the same.
+
+    for (int16_t i = 0; i < h; i++, row += line_size) {
+        uint8_t p   = fill_pattern[(y + i) & 7];
+        uint8_t set = color ? p : 0;
+        uint8_t clr = color ? 0 : p;
+
+        if (fill_pattern_bg >= 0) {
+            if (fill_pattern_bg) set |= ~p; else clr |= ~p;
+        }
+
+        row[b0] = (row[b0] | (set & first_mask)) & ~(clr & first_mask);
+        if (b0 != b1) {
+            for (int16_t b = b0 + 1; b < b1; b++) row[b] = (row[b] | set) & ~clr;
+            row[b1] = (row[b1] | (set & last_mask)) & ~(clr & last_mask);
+        }
+    }
+}
+
+void Graphics::fillPhysicalRectPattern3Bit(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    int16_t   line_size = DMemory4Bit->get_line_size();
+    uint8_t * row       = &DMemory4Bit->get_data()[line_size * y];
+
+    color &= 7;
+
+    for (int16_t i = 0; i < h; i++, row += line_size) {
+        uint8_t p = fill_pattern[(y + i) & 7];
+        for (int16_t xx = x; xx < x + w; xx++) {
+            uint8_t c;
+            if (p & (1 << (xx & 7)))
+                c = color;
+            else if (fill_pattern_bg >= 0)
+                c = fill_pattern_bg & 7;
+            else
+                continue;
+            uint8_t * b = &row[xx >> 1];
+            *b = (xx & 1) ? ((*b & 0xF0) | c) : ((*b & 0x0F) | (c << 4));
+        }
+    }
+}
@@ -0,0 +1,562 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Text rendering specializations of the Adafruit_GFX methods.
+//
+// Custom font glyphs are rasterized once in the frame buffer orientation and
+// format, for each position of their first pixel in a frame buffer byte, and
+// kept in the glyph cache. Drawing a cached glyph is then a matter of
+// combining its rows with the frame buffer bytes.
+
+#include "graphics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void Graphics::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x,
+                        uint8_t size_y)
+{
+    if (gfxFont == nullptr)
+    {
+        Adafruit_GFX::drawChar(x, y, c, color, bg, size_x, size_y);
+        return;
+    }
+
+    // Character is assumed previously filtered by write() to eliminate
+    // newlines, returns, non-printable characters, etc.
+
+    GFXglyph *      glyph  = &gfxFont->glyph[c - gfxFont->first];
+    const uint8_t * bitmap = &gfxFont->bitmap[glyph->bitmapOffset];
+
+    if ((grayFont != nullptr) && (gfxFont == &grayFont->font))
+    {
+        FontGlyph g;
+        if (getGFXGlyph(c, g)) drawGlyph(x, y, g, color, size_x, size_y);
+        return;
+    }
+
+    int16_t w  = glyph->width  * size_x;
+    int16_t h  = glyph->height * size_y;
+    int16_t x0 = x + glyph->xOffset * size_x;
+    int16_t y0 = y + glyph->yOffset * size_y;
+
+    if ((w == 0) || (h == 0)) return;
+
+    if ((x0 > clip_x1) || (y0 > clip_y1) || (x0 + w - 1 < clip_x0) || (y0 + h - 1 < clip_y0)) return;
+
+    if (glyph_cache.getCapacity() > 0)
+    {
+        int16_t px = x0, py = y0, pw = w, ph = h;
+        logicalToPhysical(px, py, pw, ph);
+
+        uint8_t offset = px & ((display_mode == DisplayMode::INKPLATE_1BIT) ? 7 : 1);
+
+        const GlyphCache::Entry * entry = getCachedGlyph(glyph, bitmap, c, pw, ph, size_x, size_y, offset);
+        if (entry != nullptr)
+        {
+            drawCachedGlyph(*entry, px - offset, py, color);
+            return;
+        }
+    }
+
+    // Scaled glyphs too large for the cache are drawn as runs
+
+    if ((size_x != 1) || (size_y != 1))
+    {
+        FontGlyph g;
+        if (getGFXGlyph(c, g)) drawScaledGlyph(x, y, g, color, size_x << 8, size_y << 8);
+        return;
+    }
+
+    withPixelSink([&](auto & sink) {
+        const uint8_t * p       = bitmap;
+        uint8_t         bits    = 0;
+        uint8_t         bit     = 0;
+        bool            visible = sink.contains(x0, y0) && sink.contains(x0 + w - 1, y0 + h - 1);
+
+        for (int16_t yy = 0; yy < h; yy++)
+        {
+            for (int16_t xx = 0; xx < w; xx++)
+            {
+                if (!(bit++ & 7))
+                    bits = *p++;
+                if (bits & 0x80)
+                {
+                    if (visible)
+                        sink.writePixel(x0 + xx, y0 + yy, color);
+                    else
+                        sink.drawPixel(x0 + xx, y0 + yy, color);
+                }
+                bits <<= 1;
+            }
+        }
+    });
+}
+
+const GlyphCache::Entry * Graphics::getCachedGlyph(const GFXglyph * glyph, const uint8_t * bitmap, unsigned char c,
+                                                   int16_t w, int16_t h, uint8_t size_x, uint8_t size_y,
+                                                   uint8_t offset)
+{
+    bool            three_bit = display_mode == DisplayMode::INKPLATE_3BIT;
+    GlyphCache::Key key       = { gfxFont, c, size_x, size_y, rotation, offset, three_bit };
+
+    // Glyphs too large to be kept are not rasterized: they are drawn directly
+
+    uint8_t shift  = three_bit ? 1 : 3;
+    int16_t stride = ((offset + w - 1) >> shift) + 1;
+
+    if (!glyph_cache.accepts((uint32_t) stride * h)) return nullptr;
+
+    const GlyphCache::Entry * entry = glyph_cache.find(key);
+    if (entry != nullptr) return entry;
+
+    // w and h are the physical size of the glyph, lw and lh its logical size
+
+    GlyphCache::Entry e;
+
+    int16_t lw = glyph->width  * size_x;
+    int16_t lh = glyph->height * size_y;
+
+    e.key    = key;
+    e.stride = stride;
+    e.rows   = h;
+    e.data.assign((size_t) e.stride * h, 0);
+
+    const uint8_t * p    = bitmap;
+    uint8_t         bits = 0;
+    uint8_t         bit  = 0;
+
+    for (int16_t yy = 0; yy < glyph->height; yy++)
+    {
+        for (int16_t xx = 0; xx < glyph->width; xx++)
+        {
+            if (!(bit++ & 7))
+                bits = *p++;
+            if (bits & 0x80)
+            {
+                for (int16_t j = yy * size_y; j < (yy + 1) * size_y; j++)
+                {
+                    for (int16_t i = xx * size_x; i < (xx + 1) * size_x; i++)
+                    {
+                        int16_t pi, pj;
+                        switch (rotation)
+                        {
+                        case 1:  pi = lh - 1 - j; pj = i;          break;
+                        case 2:  pi = lw - 1 - i; pj = lh - 1 - j; break;
+                        case 3:  pi = j;          pj = lw - 1 - i; break;
+                        default: pi = i;          pj = j;          break;
+                        }
+                        pi += offset;
+
+                        uint8_t & b = e.data[(size_t) e.stride * pj + (pi >> shift)];
+                        if (three_bit)
+                            b |= (pi & 1) ? 0x0F : 0xF0;
+                        else
+                            b |= 1 << (pi & 7);
+                    }
+                }
+            }
+            bits <<= 1;
+        }
+    }
+
+    return glyph_cache.insert(std::move(e));
+}
+
+void Graphics::drawCachedGlyph(const GlyphCache::Entry & entry, int16_t x, int16_t y, uint16_t color)
+{
+    // x is the physical position of the first frame buffer byte, the glyph
+    // starting at entry.key.offset in it. The clipping rectangle is brought
+    // to the physical orientation.
+
+    bool          three_bit    = entry.key.three_bit;
+    FrameBuffer * frame_buffer = three_bit ? (FrameBuffer *)DMemory4Bit : (FrameBuffer *)_partial;
+    uint8_t       shift        = three_bit ? 1 : 3;
+    int32_t       line_size    = frame_buffer->get_line_size();
+
+    int16_t cx = clip_x0, cy = clip_y0, cw = clip_x1 - clip_x0 + 1, ch = clip_y1 - clip_y0 + 1;
+    logicalToPhysical(cx, cy, cw, ch);
+
+    int16_t first     = std::max<int16_t>(x, cx);
+    int16_t last      = std::min<int16_t>(x + (entry.stride << shift) - 1, cx + cw - 1);
+    int16_t first_row = std::max<int16_t>(y, cy);
+    int16_t last_row  = std::min<int16_t>(y + entry.rows - 1, cy + ch - 1);
+
+    if ((first > last) || (first_row > last_row)) return;
+
+    int16_t k0 = (first - x) >> shift;
+    int16_t n  = ((last - x) >> shift) - k0 + 1;
+
+    uint8_t first_mask, last_mask;
+
+    if (three_bit) {
+        first_mask = (first & 1) ? 0x0F : 0xFF;
+        last_mask  = (last  & 1) ? 0xFF : 0xF0;
+    }
+    else {
+        first_mask = 0xFF << (first & 7);
+        last_mask  = 0xFF >> (7 - (last & 7));
+    }
+    if (n == 1) first_mask &= last_mask;
+
+    // The value written under the set mask bits
+
+    uint8_t  value   = three_bit ? (color & 7) * 0x11 : (color ? 0xFF : 0x00);
+    uint32_t value32 = value * 0x01010101U;
+
+    const uint8_t * src = &entry.data[(size_t) entry.stride * (first_row - y) + k0];
+    uint8_t *       dst = &frame_buffer->get_data()[line_size * first_row + (x >> shift) + k0];
+
+    for (int16_t r = first_row; r <= last_row; r++, src += entry.stride, dst += line_size)
+    {
+        uint8_t m = src[0] & first_mask;
+        dst[0] = (dst[0] & ~m) | (value & m);
+
+        if (n == 1) continue;
+
+        int16_t i = 1;
+        for (; i + 4 < n; i += 4)
+        {
+            uint32_t mw, dw;
+            memcpy(&mw, &src[i], 4);
+            memcpy(&dw, &dst[i], 4);
+            dw = (dw & ~mw) | (value32 & mw);
+            memcpy(&dst[i], &dw, 4);
+        }
+        for (; i < n - 1; i++)
+        {
+            dst[i] = (dst[i] & ~src[i]) | (value & src[i]);
+        }
+
+        m = src[n - 1] & last_mask;
+        dst[n - 1] = (dst[n - 1] & ~m) | (value & m);
+    }
+}
+
+void Graphics::setGrayFont(const GrayFont * font)
+{
+    setFont((font == nullptr) ? nullptr : &font->font);
+    grayFont = font;
+}
+
+void Graphics::setFontSource(FontSource * source)
+{
+    fontSource     = source;
+    utf8_remaining = 0;
+}
+
+size_t Graphics::write(uint8_t c)
+{
+    if (fontSource == nullptr)
+    {
+        // Custom fonts with a fractional scale are written here
+
+        if ((text_scale_x == 0) || (gfxFont == nullptr)) return Adafruit_GFX::write(c);
+        writeCodepoint(c);
+        return 1;
+    }
+
+    // UTF-8 decoding. Malformed sequences are dropped.
+
+    if (c < 0x80)
+    {
+        utf8_remaining = 0;
+        writeCodepoint(c);
+    }
+    else if ((c & 0xC0) == 0x80)
+    {
+        if (utf8_remaining == 0) return 1;
+        utf8_codepoint = (utf8_codepoint << 6) | (c & 0x3F);
+        if (--utf8_remaining == 0) writeCodepoint(utf8_codepoint);
+    }
+    else if ((c & 0xE0) == 0xC0) { utf8_codepoint = c & 0x1F; utf8_remaining = 1; }
+    else if ((c & 0xF0) == 0xE0) { utf8_codepoint = c & 0x0F; utf8_remaining = 2; }
+    else if ((c & 0xF8) == 0xF0) { utf8_codepoint = c & 0x07; utf8_remaining = 3; }
+    else utf8_remaining = 0;
+
+    return 1;
+}
+
+void Graphics::writeCodepoint(uint32_t codepoint)
+{
+    // Same behavior as Adafruit_GFX::write() with a custom font
+
+    uint16_t scale_x   = (text_scale_x != 0) ? text_scale_x : textsize_x << 8;
+    uint16_t scale_y   = (text_scale_y != 0) ? text_scale_y : textsize_y << 8;
+    uint8_t  y_advance = (fontSource != nullptr) ? fontSource->getYAdvance() : gfxFont->yAdvance;
+
+    if (codepoint == '\n')
+    {
+        cursor_x  = 0;
+        cursor_y += (y_advance * scale_y + 128) >> 8;
+        return;
+    }
+    if (codepoint == '\r') return;
+
+    FontGlyph glyph;
+    bool      found = (fontSource != nullptr) ? fontSource->getGlyph(codepoint, glyph) : getGFXGlyph(codepoint, glyph);
+
+    if (!found) return;
+
+    if ((glyph.width > 0) && (glyph.height > 0))
+    {
+        if (wrap && ((cursor_x + (((glyph.x_offset + glyph.width) * scale_x) >> 8)) > _width))
+        {
+            cursor_x  = 0;
+            cursor_y += (y_advance * scale_y + 128) >> 8;
+        }
+        drawScaledGlyph(cursor_x, cursor_y, glyph, textcolor, scale_x, scale_y);
+    }
+    cursor_x += (glyph.x_advance * scale_x + 128) >> 8;
+}
+
+bool Graphics::getGFXGlyph(uint32_t c, FontGlyph & glyph)
+{
+    if ((gfxFont == nullptr) || (c < gfxFont->first) || (c > gfxFont->last)) return false;
+
+    const GFXglyph * g   = &gfxFont->glyph[c - gfxFont->first];
+    uint8_t          bpp = ((grayFont != nullptr) && (gfxFont == &grayFont->font)) ? grayFont->bpp : 1;
+
+    // The rows of 1-bit glyphs are not byte aligned
+
+    glyph.bitmap      = &gfxFont->bitmap[g->bitmapOffset];
+    glyph.stride_bits = (bpp == 1) ? g->width : ((g->width * bpp + 7) & ~7);
+    glyph.bpp         = bpp;
+    glyph.width       = g->width;
+    glyph.height      = g->height;
+    glyph.x_advance   = g->xAdvance;
+    glyph.x_offset    = g->xOffset;
+    glyph.y_offset    = g->yOffset;
+
+    return true;
+}
+
+void Graphics::setTextSize(uint8_t s)
+{
+    setTextSize(s, s);
+}
+
+void Graphics::setTextSize(uint8_t s_x, uint8_t s_y)
+{
+    text_scale_x = text_scale_y = 0;
+    Adafruit_GFX::setTextSize(s_x, s_y);
+}
+
+void Graphics::setTextScale(float s)
+{
+    setTextScale(s, s);
+}
+
+void Graphics::setTextScale(float s_x, float s_y)
+{
+    // The closest integer sizes are kept for the Adafruit_GFX methods
+    // (getTextBounds(), the built-in font)
+
+    long size_x = std::min(std::max(lroundf(s_x), 1L), 255L);
+    long size_y = std::min(std::max(lroundf(s_y), 1L), 255L);
+
+    Adafruit_GFX::setTextSize(size_x, size_y);
+
+    if ((s_x == size_x) && (s_y == size_y))
+    {
+        text_scale_x = text_scale_y = 0;
+    }
+    else
+    {
+        text_scale_x = std::min(std::max(lroundf(s_x * 256), 1L), 65535L);
+        text_scale_y = std::min(std::max(lroundf(s_y * 256), 1L), 65535L);
+    }
+}
+
+Graphics::TextState Graphics::getTextState() const
+{
+    return { gfxFont, grayFont, fontSource, textsize_x, textsize_y, text_scale_x, text_scale_y,
+             wrap, textcolor, textbgcolor, cursor_x, cursor_y };
+}
+
+void Graphics::setTextState(const TextState & state)
+{
+    gfxFont        = (GFXfont *) state.font;
+    grayFont       = state.grayFont;
+    fontSource     = state.fontSource;
+    utf8_remaining = 0;
+    textsize_x     = state.size_x;
+    textsize_y     = state.size_y;
+    text_scale_x   = state.scale_x;
+    text_scale_y   = state.scale_y;
+    wrap           = state.wrap;
+    textcolor      = state.color;
+    textbgcolor    = state.bg;
+    cursor_x       = state.cursor_x;
+    cursor_y       = state.cursor_y;
+}
+
+// Calls fill(x, y, w, h) with the screen rectangles covered by the set
+// pixels of a w x h glyph, scaled by scale_x and scale_y (8.8 fixed point).
+// Glyph pixel i covers screen pixels (i * scale) >> 8 up to, but not
+// including, ((i + 1) * scale) >> 8. Identical consecutive rows (the stems
+// of large characters) are drawn together.
+
+template <typename Set, typename Fill>
+static void scaledRuns(int16_t w, int16_t h, uint16_t scale_x, uint16_t scale_y, Set set, Fill fill)
+{
+    int16_t j = 0;
+
+    while (j < h)
+    {
+        int16_t k = j + 1;
+
+        for (; k < h; k++)
+        {
+            int16_t i = 0;
+            while ((i < w) && (set(i, j) == set(i, k))) i++;
+            if (i < w) break;
+        }
+
+        int16_t y0 = ((int32_t) j * scale_y) >> 8;
+        int16_t y1 = ((int32_t) k * scale_y) >> 8;
+
+        if (y1 > y0)
+        {
+            for (int16_t i = 0; i < w;)
+            {
+                if (!set(i, j)) { i++; continue; }
+
+                int16_t first = i;
+                while ((i < w) && set(i, j)) i++;
+
+                int16_t x0 = ((int32_t) first * scale_x) >> 8;
+                int16_t x1 = ((int32_t) i     * scale_x) >> 8;
+
+                if (x1 > x0) fill(x0, y0, x1 - x0, y1 - y0);
+            }
+        }
+
+        j = k;
+    }
+}
+
+void Graphics::drawGlyph(int16_t x, int16_t y, const FontGlyph & glyph, uint16_t color, uint8_t size_x,
+                         uint8_t size_y)
+{
+    drawScaledGlyph(x, y, glyph, color, size_x << 8, size_y << 8);
+}
+
+void Graphics::drawScaledGlyph(int16_t x, int16_t y, const FontGlyph & glyph, uint16_t color, uint16_t scale_x,
+                               uint16_t scale_y)
+{
+    const uint8_t * bitmap = glyph.bitmap;
+
+    uint8_t  bpp    = glyph.bpp;
+    uint8_t  max    = (1 << bpp) - 1;
+    int16_t  gw     = glyph.width;
+    int16_t  gh     = glyph.height;
+    uint16_t stride = glyph.stride_bits;
+    int16_t  x0     = x + (((int32_t) glyph.x_offset * scale_x) >> 8);
+    int16_t  y0     = y + (((int32_t) glyph.y_offset * scale_y) >> 8);
+    int16_t  w      = ((int32_t) gw * scale_x) >> 8;
+    int16_t  h      = ((int32_t) gh * scale_y) >> 8;
+    bool     scaled = (scale_x != 256) || (scale_y != 256);
+
+    if ((w == 0) || (h == 0) || (bitmap == nullptr)) return;
+
+    if ((x0 > clip_x1) || (y0 > clip_y1) || (x0 + w - 1 < clip_x0) || (y0 + h - 1 < clip_y0)) return;
+
+    auto coverage = [&](int16_t i, int16_t j) -> uint8_t {
+        uint32_t bit = (uint32_t) j * stride + i * bpp;
+        return (bitmap[bit >> 3] >> (8 - bpp - (bit & 7))) & max;
+    };
+
+    // In 1-bit mode, and for 1-bit glyphs in 3-bit mode, pixels covered at
+    // least by half get the color: the glyph is made of rectangles.
+
+    if ((display_mode == DisplayMode::INKPLATE_1BIT) || (bpp == 1))
+    {
+        if ((display_mode == DisplayMode::INKPLATE_1BIT) && (bpp == 1) && ((stride & 7) == 0) && !scaled)
+        {
+            blit(x0, y0, bitmap, stride >> 3, 0, 0, gw, gh, color ? RasterOp::OR : RasterOp::AND_NOT);
+            return;
+        }
+
+        scaledRuns(gw, gh, scale_x, scale_y,
+                   [&](int16_t i, int16_t j) { return (coverage(i, j) << 1) > max; },
+                   [&](int16_t dx, int16_t dy, int16_t dw, int16_t dh) {
+                       writeFillRect(x0 + dx, y0 + dy, dw, dh, color);
+                   });
+        return;
+    }
+
+    color &= 7;
+    if (gray_lut_color != color)
+    {
+        for (int16_t a = 0; a < 16; a++)
+            for (int16_t d = 0; d < 8; d++)
+                gray_lut[a][d] = (d * (15 - a) + color * a + 7) / 15;
+        gray_lut_color = color;
+    }
+
+    // Coverage brought to 4 bits
+
+    uint8_t scale = 15 / max;
+
+    if ((rotation == 0) && !scaled)
+    {
+        // Straight into the frame buffer nibbles
+
+        int16_t   first     = std::max<int16_t>(0, clip_x0 - x0);
+        int16_t   last      = std::min<int16_t>(gw - 1, clip_x1 - x0);
+        int16_t   first_row = std::max<int16_t>(0, clip_y0 - y0);
+        int16_t   last_row  = std::min<int16_t>(gh - 1, clip_y1 - y0);
+        int32_t   line_size = DMemory4Bit->get_line_size();
+        uint8_t * data      = DMemory4Bit->get_data();
+
+        for (int16_t j = first_row; j <= last_row; j++)
+        {
+            uint8_t * dst = &data[line_size * (y0 + j)];
+
+            for (int16_t i = first; i <= last; i++)
+            {
+                uint8_t a = coverage(i, j);
+                if (a == 0) continue;
+
+                int16_t   px = x0 + i;
+                uint8_t * p  = &dst[px >> 1];
+                a *= scale;
+                if (px & 1)
+                    *p = (*p & 0xF0) | gray_lut[a][*p & 0x07];
+                else
+                    *p = (*p & 0x0F) | (gray_lut[a][(*p >> 4) & 0x07] << 4);
+            }
+        }
+        return;
+    }
+
+    // Each glyph pixel is blended in the screen pixels it covers
+
+    withPixelSink([&](auto & sink) {
+        for (int16_t j = 0; j < gh; j++)
+        {
+            int16_t top    = y0 + (((int32_t) j       * scale_y) >> 8);
+            int16_t bottom = y0 + (((int32_t) (j + 1) * scale_y) >> 8);
+
+            for (int16_t i = 0; i < gw; i++)
+            {
+                uint8_t a = coverage(i, j) * scale;
+                if (a == 0) continue;
+
+                int16_t left  = x0 + (((int32_t) i       * scale_x) >> 8);
+                int16_t right = x0 + (((int32_t) (i + 1) * scale_x) >> 8);
+
+                for (int16_t py = top; py < bottom; py++)
+                {
+                    for (int16_t px = left; px < right; px++)
+                    {
+                        if (sink.contains(px, py)) sink.writePixel(px, py, gray_lut[a][sink.getPixel(px, py) & 7]);
+                    }
+                }
+            }
+        }
+    });
+}
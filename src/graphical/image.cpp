@@ -17,6 +17,7 @@ Distributed as-is; no warranty is given.
 #include "image.hpp"
 
 #include "tjpg_decoder.hpp"
+#include "network_client.hpp"
 
 Image *_imagePtrJpeg = nullptr;
 Image *_imagePtrPng  = nullptr;
@@ -28,6 +29,29 @@ Image::Image(int16_t w, int16_t h) : Adafruit_GFX(w, h), e_ink_width(w), e_ink_h
 
     pixelBuffer  = new uint8_t[pixelBufferSize = (e_ink_width * 4 + 5)];
     ditherBuffer = new uint8_t[ditherBufferSize = (2 * e_ink_width + 20)];
+    rowBuffer    = new uint8_t[rowBufferSize    = e_ink_width];
+}
+
+void Image::bufferPixel(int16_t x, int16_t y, uint8_t color)
+{
+    if ((rowCount > 0) && ((y != rowY) || (x != (rowX + rowCount)) || (rowCount == rowBufferSize)))
+        flushPixelRow();
+
+    if (rowCount == 0)
+    {
+        rowX = x;
+        rowY = y;
+    }
+    rowBuffer[rowCount++] = color;
+}
+
+void Image::flushPixelRow()
+{
+    if (rowCount > 0)
+    {
+        writePixelRow(rowX, rowY, rowBuffer, rowCount);
+        rowCount = 0;
+    }
 }
 
 bool Image::drawImage(const std::string path, int x, int y, bool dither, bool invert)
@@ -98,20 +122,49 @@ bool Image::drawImage(const char *path, const Format& format, const int x, const
 }
 
 bool Image::drawImage(const char* path, const Format& format, const Position& position, const bool dither, const bool invert) {
+    return drawImage(path, format, Rect{ 0, 0, width(), height() }, NoScaling, position, dither, invert);
+}
+
+bool Image::drawImage(const char *path, const Format &format, const Rect &box, const Scaling &scaling,
+                      const Position &position, const bool dither, const bool invert)
+{
+    boxSettings = { box, scaling, position, true, dither, invert };
+
     if (strncmp(path, "http://", 7) == 0 || strncmp(path, "https://", 8) == 0)
     {
+        if (format == BMP)
+            return drawBitmapInBox(path, nullptr);
         if (format == JPG)
-            return drawJpegFromWebAtPosition(path, position, dither, invert);
-
-        //TODO: implement
-        return false;
+            return drawJpegInBox(path, nullptr);
+        if (format == PNG)
+            return drawPngInBox(path, nullptr);
+        return 0;
     }
-    else
+
+    FILE * p = fopen(path, "r");
+    bool ret = 0;
+
+    if (p)
     {
-        //TODO: implement
-        return false;
+        if (format == BMP)
+            ret = drawBitmapInBox(nullptr, p);
+        if (format == JPG)
+            ret = drawJpegInBox(nullptr, p);
+        if (format == PNG)
+            ret = drawPngInBox(nullptr, p);
+        fclose(p);
     }
-    return false;
+    return ret;
+}
+
+int32_t Image::readFile(void *context, uint8_t *buf, uint32_t len)
+{
+    return fread(buf, 1, len, (FILE *)context);
+}
+
+int32_t Image::readWeb(void * /* context */, uint8_t *buf, uint32_t len)
+{
+    return network_client.readStream(buf, len);
 }
 
 
@@ -119,21 +172,10 @@ void Image::drawBitmap3Bit(int16_t _x, int16_t _y, const unsigned char *_p, int1
 {
     if (getDisplayMode() != DisplayMode::INKPLATE_3BIT)
         return;
-    uint8_t _rem = _w & 1;
-    int i, j;
-    int xSize = (_w >> 1) + _rem;
+    int xSize = (_w + 1) >> 1;
 
     startWrite();
-    for (i = 0; i < _h; i++)
-    {
-        for (j = 0; j < xSize - 1; j++)
-        {
-            writePixel((j * 2) + _x, i + _y, (*(_p + xSize * (i) + j) >> 4) >> 1);
-            writePixel((j * 2) + 1 + _x, i + _y, (*(_p + xSize * (i) + j) & 0xff) >> 1);
-        }
-        writePixel((j * 2) + _x, i + _y, (*(_p + xSize * (i) + j) >> 4) >> 1);
-        if (_rem == 0)
-            writePixel((j * 2) + 1 + _x, i + _y, (*(_p + xSize * (i) + j) & 0xff) >> 1);
-    }
+    for (int i = 0; i < _h; i++)
+        writeNibbleRow(_x, _y + i, _p + xSize * i, _w);
     endWrite();
 }
@@ -126,14 +126,111 @@ bool Image::drawBitmapFromFile(FILE * p, int x, int y, bool dither, bool invert)
     return 1;
 }
 
-bool Image::drawBitmapFromWeb(const char *url, int x, int y, bool dither, bool invert)
+// The header is read up to the pixels (palette included), from a stream
+// that can't be rewound
+
+bool Image::readBmpHeaderFromStream(ImageReader reader, void *context, bitmapHeader *h)
 {
+    uint8_t header[55];
     bool ret = 0;
-    int32_t defaultLen = e_ink_width * e_ink_height * 4 + 150;
-    uint8_t *buf = network_client.downloadFile(url, &defaultLen);
 
-    ret = drawBitmapFromBuffer(buf, x, y, dither, invert);
-    free(buf);
+    if (reader(context, header, 54) == 54)
+    {
+        uint32_t startRAW = read32(header + 10);
+
+        if ((startRAW >= 54) && (startRAW <= 54 + 1024 + 100) && (read32(header + 46) <= 256))
+        {
+            uint8_t *buf = new uint8_t[54 + 1024 + 100]();
+            memcpy(buf, header, 54);
+            if (reader(context, buf + 54, startRAW - 54) == (int32_t)(startRAW - 54))
+            {
+                readBmpHeader(buf, h);
+                ret = legalBmp(h) && (rowSize(h->width, h->color) <= pixelBufferSize);
+            }
+            delete [] buf;
+        }
+    }
+
+    return ret;
+}
+
+bool Image::drawBitmapFromWeb(const char *url, int x, int y, bool dither, bool invert)
+{
+    // The download is read as it arrives: the header, then a row at a time.
+
+    if (!network_client.openStream(url))
+        return 0;
+
+    bitmapHeader bmpHeader;
+    bool ret = readBmpHeaderFromStream(readWeb, nullptr, &bmpHeader);
+
+    if (ret)
+    {
+        int16_t n = rowSize(bmpHeader.width, bmpHeader.color);
+
+        if (dither)
+            memset(ditherBuffer, 0, ditherBufferSize);
+
+        for (uint32_t i = 0; i < bmpHeader.height; ++i)
+        {
+            if (network_client.readStream(pixelBuffer, n) != n)
+            {
+                ret = 0;
+                break;
+            }
+            displayBmpLine(x, y + bmpHeader.height - i - 1, &bmpHeader, dither, invert);
+        }
+    }
+
+    network_client.closeStream();
+
+    return ret;
+}
+
+// Image drawn in a box: the rows, bottom-up, are converted to gray levels
+// and pushed to the resampler
+
+bool Image::drawBitmapInBox(const char *url, FILE *p)
+{
+    ImageReader reader  = url ? readWeb : readFile;
+    void *      context = p;
+
+    if (url && !network_client.openStream(url))
+        return 0;
+
+    bitmapHeader bmpHeader;
+    bool ret = readBmpHeaderFromStream(reader, context, &bmpHeader) &&
+               (bmpHeader.width <= INT16_MAX) && (bmpHeader.height <= INT16_MAX);
+
+    if (ret)
+    {
+        int16_t w = bmpHeader.width, h = bmpHeader.height;
+        int16_t tw, th;
+
+        scaledSize(w, h, tw, th);
+        ret = startResampling(w, h, tw, th, 1, true);
+    }
+
+    if (ret && resampler)
+    {
+        int16_t n = rowSize(bmpHeader.width, bmpHeader.color);
+
+        for (uint32_t i = 0; (i < bmpHeader.height) && !resampler->isComplete(); ++i)
+        {
+            if (reader(context, pixelBuffer, n) != n)
+            {
+                ret = 0;
+                break;
+            }
+            bmpLineToGray(&bmpHeader, resampleRows);
+            resampler->pushRow(resampleRows);
+        }
+
+        stopResampling();
+    }
+
+    if (url)
+        network_client.closeStream();
 
     return ret;
 }
@@ -172,7 +269,7 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
         switch (c)
         {
         case 1:
-            writePixel(x + j, y, (invert ^ (palette[0] > palette[1])) ^ !!(pixelBuffer[j >> 3] & (1 << (7 - (j & 7)))));
+            bufferPixel(x + j, y, (invert ^ (palette[0] > palette[1])) ^ !!(pixelBuffer[j >> 3] & (1 << (7 - (j & 7)))));
             break;
         // as for 2 bit, literally cannot find an example online or in PS, so skipped
         case 4: {
@@ -188,7 +285,7 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
             if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
 
-            writePixel(x + j, y, val);
+            bufferPixel(x + j, y, val);
             break;
         }
         case 8: {
@@ -204,7 +301,7 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
             if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
 
-            writePixel(x + j, y, val);
+            bufferPixel(x + j, y, val);
             break;
         }
         case 16: {
@@ -225,13 +322,13 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
             if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
 
-            writePixel(x + j, y, val);
+            bufferPixel(x + j, y, val);
             break;
         }
-        case 24: {
-            uint8_t r = pixelBuffer[j * 3];
+        case 24: { // Stored as blue, green, red
+            uint8_t b = pixelBuffer[j * 3];
             uint8_t g = pixelBuffer[j * 3 + 1];
-            uint8_t b = pixelBuffer[j * 3 + 2];
+            uint8_t r = pixelBuffer[j * 3 + 2];
 
             uint8_t val;
 
@@ -244,13 +341,13 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
             if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
 
-            writePixel(x + j, y, val);
+            bufferPixel(x + j, y, val);
             break;
         }
         case 32:
-            uint8_t r = pixelBuffer[j * 4];
+            uint8_t b = pixelBuffer[j * 4];
             uint8_t g = pixelBuffer[j * 4 + 1];
-            uint8_t b = pixelBuffer[j * 4 + 2];
+            uint8_t r = pixelBuffer[j * 4 + 2];
 
             uint8_t val;
 
@@ -263,11 +360,45 @@ void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool d
             if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
 
-            writePixel(x + j, y, val);
+            bufferPixel(x + j, y, val);
             break;
         }
     }
 
+    flushPixelRow();
     ditherSwap(w);
     endWrite();
 }
+
+void Image::bmpLineToGray(bitmapHeader *bmpHeader, uint8_t *gray)
+{
+    int16_t w = bmpHeader->width;
+
+    for (int j = 0; j < w; ++j)
+    {
+        switch (bmpHeader->color)
+        {
+        case 1:
+            gray[j] = ditherPalette[!!(pixelBuffer[j >> 3] & (1 << (7 - (j & 7))))];
+            break;
+        case 4:
+            gray[j] = ditherPalette[(pixelBuffer[j >> 1] >> (j & 1 ? 0 : 4)) & 0x0F];
+            break;
+        case 8:
+            gray[j] = ditherPalette[pixelBuffer[j]];
+            break;
+        case 16: {
+            uint16_t px = ((uint16_t)pixelBuffer[(j << 1) | 1] << 8) | pixelBuffer[(j << 1)];
+
+            gray[j] = rgb8Bit((px & 0x7C00) >> 7, (px & 0x3E0) >> 2, (px & 0x1F) << 3);
+            break;
+        }
+        case 24: // Stored as blue, green, red
+            gray[j] = rgb8Bit(pixelBuffer[j * 3 + 2], pixelBuffer[j * 3 + 1], pixelBuffer[j * 3]);
+            break;
+        case 32:
+            gray[j] = rgb8Bit(pixelBuffer[j * 4 + 2], pixelBuffer[j * 4 + 1], pixelBuffer[j * 4]);
+            break;
+        }
+    }
+}
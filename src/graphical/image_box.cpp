@@ -0,0 +1,154 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Images drawn in a box. Once a decoder knows the image size, the scaled
+// size and position are computed and an ImageResampler is set up for the
+// visible part of the scaled image only (in the box and the clipping
+// rectangle). The decoders then convert their pixels to gray levels, in
+// rows, and push them to the resampler, whose output rows are dithered (or
+// not) as usual and drawn. When no part of the image is visible, no
+// resampler is set up and the decoders stop there, successfully.
+
+#include "image.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+void Image::scaledSize(uint16_t w, uint16_t h, int16_t &tw, int16_t &th)
+{
+    const Rect &box = boxSettings.box;
+    uint32_t    sw  = w, sh = h;
+    bool        fits = (w <= box.w) && (h <= box.h);
+
+    if ((boxSettings.scaling != NoScaling) && (w > 0) && (h > 0) && (boxSettings.enlarge || !fits))
+    {
+        // Fitting uses the smallest ratio of the box and image sizes,
+        // filling the largest one
+
+        bool wider = (uint32_t)w * box.h > (uint32_t)h * box.w;
+
+        if (wider == (boxSettings.scaling == ScaleToFit))
+        {
+            sw = box.w;
+            sh = ((uint32_t)h * box.w + (w >> 1)) / w;
+        }
+        else
+        {
+            sh = box.h;
+            sw = ((uint32_t)w * box.h + (h >> 1)) / h;
+        }
+    }
+
+    tw = std::min<uint32_t>(std::max<uint32_t>(sw, 1), INT16_MAX);
+    th = std::min<uint32_t>(std::max<uint32_t>(sh, 1), INT16_MAX);
+}
+
+bool Image::startResampling(int16_t w, int16_t h, int16_t tw, int16_t th, int16_t rows, bool flip)
+{
+    const Rect &box = boxSettings.box;
+
+    int32_t x = box.x;
+    int32_t y = box.y;
+
+    switch (boxSettings.position)
+    {
+    case Center:
+        x += ((int32_t)box.w - tw) / 2;
+        y += ((int32_t)box.h - th) / 2;
+        break;
+    case TopLeft:
+        break;
+    case BottomLeft:
+        y += (int32_t)box.h - th;
+        break;
+    case TopRight:
+        x += (int32_t)box.w - tw;
+        break;
+    case BottomRight:
+        x += (int32_t)box.w - tw;
+        y += (int32_t)box.h - th;
+        break;
+    }
+
+    // Visible part of the scaled image
+
+    Rect clip = getClipRect();
+
+    int32_t x0 = std::max({ x, (int32_t)box.x, (int32_t)clip.x });
+    int32_t y0 = std::max({ y, (int32_t)box.y, (int32_t)clip.y });
+    int32_t x1 = std::min({ x + tw, (int32_t)box.x + box.w, (int32_t)clip.x + clip.w });
+    int32_t y1 = std::min({ y + th, (int32_t)box.y + box.h, (int32_t)clip.y + clip.h });
+
+    // Nothing visible: there is nothing to decode, resampler stays nullptr
+
+    if ((x1 <= x0) || (y1 <= y0))
+        return true;
+
+    // With bottom-up rows, the window is upside down too
+
+    Rect window = { (int16_t)(x0 - x), (int16_t)(flip ? (y + th - y1) : (y0 - y)),
+                    (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+
+    resampleSrcWidth = w;
+    resampleRowCount = rows;
+    resampleX = x0;
+    resampleWidth = x1 - x0;
+    resampleY = y;
+    resampleHeight = th;
+    resampleFlip = flip;
+
+    resampleRows = (uint8_t *)malloc((size_t)w * rows);
+    resampler = new ImageResampler(w, h, tw, th, window, drawResampledRow, this);
+
+    if ((resampleRows == nullptr) || !resampler->isReady())
+    {
+        stopResampling();
+        return false;
+    }
+
+    rowCount = 0;
+    if (boxSettings.dither)
+        memset(ditherBuffer, 0, ditherBufferSize);
+
+    return true;
+}
+
+void Image::stopResampling()
+{
+    delete resampler;
+    resampler = nullptr;
+
+    free(resampleRows);
+    resampleRows = nullptr;
+}
+
+void Image::drawResampledRow(void *context, int16_t row, const uint8_t *gray)
+{
+    Image * img = (Image *)context;
+
+    int16_t y = img->resampleFlip ? img->resampleY + img->resampleHeight - 1 - row : img->resampleY + row;
+    int16_t w = img->resampleWidth;
+
+    bool one_bit = img->getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+
+    img->startWrite();
+    for (int i = 0; i < w; ++i)
+    {
+        uint8_t val;
+        if (img->boxSettings.dither)
+            val = img->ditherGetPixelBmp(gray[i], i, w, 0);
+        else
+            val = gray[i] >> 5;
+        if (img->boxSettings.invert)
+            val = 7 - val;
+        if (one_bit)
+            val = (~val >> 2) & 1;
+        img->bufferPixel(img->resampleX + i, y, val);
+    }
+    img->flushPixelRow();
+    if (img->boxSettings.dither)
+        img->ditherSwap(w);
+    img->endWrite();
+}
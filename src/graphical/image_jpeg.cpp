@@ -15,7 +15,6 @@ Distributed as-is; no warranty is given.
 */
 
 #include <cstdio>
-#include <sys/stat.h>
 
 #include "image.hpp"
 
@@ -45,61 +44,126 @@ bool Image::drawJpegFromFile(FILE * p, int x, int y, bool dither, bool invert)
     TJpgDec.setJpgScale(1);
     TJpgDec.setCallback(drawJpegChunk);
 
-    struct stat stat_buf;
-    fstat(fileno(p), &stat_buf);
-    uint32_t total = stat_buf.st_size;
+    // Decoded as read: the file is not loaded in memory
 
-    uint8_t *buff = (uint8_t *)malloc(total);
+    if (TJpgDec.drawJpg(x, y, p, dither, invert) == 0) ret = 1;
 
-    if (buff == NULL) return 0;
+    fclose(p);
 
-    if (fread(buff, total, 1, p) != 1) return 0;
+    return ret;
+}
 
-    fclose(p);
+bool Image::drawJpegFromWeb(const char *url, int x, int y, bool dither, bool invert)
+{
+    bool ret = 0;
+
+    // The download is decoded as it arrives, never kept whole in memory
+
+    if (!network_client.openStream(url))
+        return 0;
+
+    blockW = -1;
+    blockH = -1;
+    lastY = -1;
+    memset(ditherBuffer, 0, ditherBufferSize);
+
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setCallback(drawJpegChunk);
 
-    if (TJpgDec.drawJpg(x, y, buff, total, dither, invert) == 0) ret = 1;
+    if (TJpgDec.drawJpg(x, y, readWeb, nullptr, dither, invert) == 0) ret = 1;
 
-    free(buff);
+    network_client.closeStream();
 
     return ret;
 }
 
-bool Image::drawJpegFromWeb(const char *url, int x, int y, bool dither, bool invert)
+bool Image::drawJpegFromFile(const char *fileName, const Rect &box, bool dither, bool invert)
 {
-    bool ret = 0;
+    FILE * dat = fopen(fileName, "r");
+    if (dat)
+        return drawJpegFromFile(dat, box, dither, invert);
+    return 0;
+}
 
-    int32_t defaultLen = e_ink_width * e_ink_height * 4;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+bool Image::drawJpegFromFile(FILE *p, const Rect &box, bool dither, bool invert)
+{
+    boxSettings = { box, ScaleToFit, Center, false, dither, invert };
 
-    ret = drawJpegFromBuffer(buff, defaultLen, x, y, dither, invert);
-    free(buff);
+    bool ret = drawJpegInBox(nullptr, p);
+
+    fclose(p);
 
     return ret;
 }
 
-bool Image::drawJpegFromWebAtPosition(const char *url, const Position& position, const bool dither, const bool invert)
+bool Image::drawJpegFromWeb(const char *url, const Rect &box, bool dither, bool invert)
 {
-    bool ret = 0;
+    boxSettings = { box, ScaleToFit, Center, false, dither, invert };
 
-    int32_t defaultLen = 800 * 600 * 4;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+    return drawJpegInBox(url, nullptr);
+}
 
+bool Image::drawJpegInBox(const char *url, FILE *p)
+{
     uint16_t w = 0;
     uint16_t h = 0;
-    TJpgDec.setJpgScale(1);
-    JRESULT r = TJpgDec.getJpgSize(&w, &h, buff, defaultLen);
-    if(r != JDR_OK) {
-        free(buff);
-        return false;
+    JRESULT r;
+
+    // A stream can't be rewound: the size is read from the start of a first
+    // download, stopped there.
+
+    if (url)
+    {
+        if (!network_client.openStream(url))
+            return 0;
+        r = TJpgDec.getJpgSize(&w, &h, readWeb, nullptr);
+        network_client.closeStream();
     }
+    else
+        r = TJpgDec.getJpgSize(&w, &h, p);
 
-    uint16_t posX, posY;
-    getPointsForPosition(position, w, h, 800, 600, &posX, &posY);
+    if (r != JDR_OK)
+        return 0;
 
-    ret = drawJpegFromBuffer(buff, defaultLen, posX, posY, dither, invert);
-    free(buff);
+    // The largest decoder scaling still giving at least the scaled size,
+    // the resampler doing the rest
 
-    return ret;
+    int16_t tw, th;
+    uint8_t scale = 0;
+
+    scaledSize(w, h, tw, th);
+
+    while ((scale < 3) && ((w >> (scale + 1)) >= tw) && ((h >> (scale + 1)) >= th))
+        scale++;
+
+    // Blocks are gathered in rows of MCUs (at most 16 pixels high)
+
+    if (!startResampling(w >> scale, h >> scale, tw, th, 16 >> scale, false))
+        return 0;
+    if (resampler == nullptr)
+        return 1;
+
+    if (url && !network_client.openStream(url))
+    {
+        stopResampling();
+        return 0;
+    }
+
+    TJpgDec.setJpgScale(1 << scale);
+    TJpgDec.setCallback(drawJpegChunk);
+
+    if (url)
+        r = TJpgDec.drawJpg(0, 0, readWeb, nullptr, boxSettings.dither, boxSettings.invert);
+    else
+        r = TJpgDec.drawJpg(0, 0, p, boxSettings.dither, boxSettings.invert);
+
+    if (url)
+        network_client.closeStream();
+
+    stopResampling();
+    TJpgDec.setJpgScale(1);
+
+    return r == JDR_OK;
 }
 
 bool Image::drawJpegFromBuffer(uint8_t *buff, int32_t len, int x, int y, bool dither, bool invert)
@@ -125,12 +189,55 @@ bool Image::drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t
     if (!_imagePtrJpeg)
         return 0;
 
+    // Image drawn in a box: the block is kept in a row of blocks, sent to
+    // the resampler when complete
+
+    Image * img = _imagePtrJpeg;
+
+    if (img->resampler)
+    {
+        int16_t   sw   = img->resampleSrcWidth;
+        uint8_t * rows = img->resampleRows;
+
+        if (h > img->resampleRowCount)
+            h = img->resampleRowCount;
+
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; (i < w) && (x + i < sw); ++i)
+            {
+                uint16_t rgb = bitmap[j * w + i];
+                rows[j * sw + x + i] = rgb8Bit(red(rgb), green(rgb), blue(rgb));
+            }
+
+        if (x + w >= sw)
+            for (int j = 0; j < h; ++j)
+                img->resampler->pushRow(&rows[j * sw]);
+
+        return 1;
+    }
+
     if (dither && y != _imagePtrJpeg->lastY)
     {
         _imagePtrJpeg->ditherSwap(e_ink.get_width());
         _imagePtrJpeg->lastY = y;
     }
 
+    // Without dithering, blocks outside of the clipping rectangle are
+    // skipped. With it, they carry the errors to the next ones.
+
+    if (!dither)
+    {
+        Rect clip = _imagePtrJpeg->getClipRect();
+        if ((x >= clip.x + clip.w) || (y >= clip.y + clip.h) || (x + w <= clip.x) || (y + h <= clip.y))
+            return 1;
+    }
+
+    // The block is kept whole if possible, such that rotated screens are
+    // written a frame buffer byte at a time.
+
+    bool      whole  = (w * h) <= _imagePtrJpeg->rowBufferSize;
+    uint8_t * colors = _imagePtrJpeg->rowBuffer;
+
     _imagePtrJpeg->startWrite();
     for (int j = 0; j < h; ++j)
     {
@@ -146,9 +253,16 @@ bool Image::drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t
                 val = 7 - val;
             if (_imagePtrJpeg->getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                 val = (~val >> 2) & 1;
-            _imagePtrJpeg->writePixel(x + i, y + j, val);
+            if (whole)
+                colors[j * w + i] = val;
+            else
+                _imagePtrJpeg->bufferPixel(x + i, y + j, val);
         }
     }
+    if (whole)
+        _imagePtrJpeg->writePixelBlock(x, y, w, h, colors);
+    else
+        _imagePtrJpeg->flushPixelRow();
     if (dither)
         _imagePtrJpeg->ditherSwapBlockJpeg(x);
     _imagePtrJpeg->endWrite();
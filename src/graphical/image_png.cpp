@@ -20,7 +20,6 @@ Distributed as-is; no warranty is given.
 #include "pngle.hpp"
 #include "network_client.hpp"
 
-#include <sys/stat.h>
 
 extern Image *_imagePtrPng;
 
@@ -44,7 +43,7 @@ void pngle_on_draw(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t
                     px = 7 - px;
                 if (_imagePtrPng->getDisplayMode() == DisplayMode::INKPLATE_1BIT)
                     px = (~px >> 2) & 1;
-                _imagePtrPng->drawPixel(_pngX + x + i, _pngY + y + j, px);
+                _imagePtrPng->bufferPixel(_pngX + x + i, _pngY + y + j, px);
             }
     if (lastY != y)
     {
@@ -62,6 +61,41 @@ bool Image::drawPngFromFile(const char * fileName, int x, int y, bool dither, bo
     return 0;
 }
 
+// The PNG data is fed to the decoder a chunk at a time, as read. The bytes
+// not consumed by pngle (an incomplete chunk header) are kept for the next
+// feed. The callbacks can end the decoding early by setting *stop.
+
+static bool feedPng(pngle_t *pngle, Image::ImageReader reader, void *context, const bool *stop = nullptr)
+{
+    uint8_t buff[2048];
+    int32_t remain = 0;
+    bool    done   = false;
+
+    while (!done)
+    {
+        int32_t size = sizeof(buff) - remain;
+        int32_t len  = reader(context, buff + remain, size);
+
+        if (len < 0)
+            return false;
+
+        done = len < size;
+        len += remain;
+
+        // Nothing consumed from a full buffer: pngle can't go further
+
+        int fed = pngle_feed(pngle, buff, len);
+        if ((fed < 0) || (stop && *stop) || ((fed == 0) && (len == sizeof(buff))))
+            return false;
+
+        remain = len - fed;
+        if (remain > 0)
+            memmove(buff, buff + fed, remain);
+    }
+
+    return true;
+}
+
 bool Image::drawPngFromFile(FILE * p, int x, int y, bool dither, bool invert)
 {
     _pngDither = dither;
@@ -77,24 +111,9 @@ bool Image::drawPngFromFile(FILE * p, int x, int y, bool dither, bool invert)
     _pngY = y;
     pngle_set_draw_callback(pngle, pngle_on_draw);
 
-    struct stat stat_buf;
-    fstat(fileno(p), &stat_buf);
-    uint32_t total = stat_buf.st_size;
-
-    uint8_t buff[2048];
-        
-    uint32_t toread = total;
-
-    while (toread > 0)
-    {
-      int len = fread(buff, std::min((uint32_t)2048, toread), 1, p);
-      if (pngle_feed(pngle, buff, len) < 0) {
-          ret = 0;
-          break;
-      }
-      toread -= len;
-    }
+    ret = feedPng(pngle, readFile, p);
 
+    flushPixelRow();
     fclose(p);
     pngle_destroy(pngle);
     return ret;
@@ -108,6 +127,11 @@ bool Image::drawPngFromWeb(const char *url, int x, int y, bool dither, bool inve
 
     bool ret = 1;
 
+    // The download is decoded as it arrives, never kept whole in memory
+
+    if (!network_client.openStream(url))
+        return 0;
+
     if (dither)
         memset(ditherBuffer, 0, ditherBufferSize);
 
@@ -116,18 +140,81 @@ bool Image::drawPngFromWeb(const char *url, int x, int y, bool dither, bool inve
     _pngY = y;
     pngle_set_draw_callback(pngle, pngle_on_draw);
 
-    int32_t defaultLen = e_ink_width * e_ink_height * 4 + 100;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+    ret = feedPng(pngle, readWeb, nullptr);
 
-    if (!buff)
+    flushPixelRow();
+    network_client.closeStream();
+    pngle_destroy(pngle);
+    return ret;
+}
+
+// Image drawn in a box: the resampler is set up once the header is read,
+// and each row of pixels, composed over white, is pushed to it. Interlaced
+// images, whose rows come in many passes, are not supported. The decoding
+// stops on error, or once the last row has been pushed.
+
+struct PngBox
+{
+    Image * image;
+    bool    stop;
+    bool    error;
+};
+
+bool Image::drawPngInBox(const char *url, FILE *p)
+{
+    if (url && !network_client.openStream(url))
         return 0;
 
-    if (pngle_feed(pngle, buff, defaultLen) < 0)
-        ret = 0;
+    PngBox box = { this, false, false };
+
+    pngle_t *pngle = pngle_new();
+    pngle_set_user_data(pngle, &box);
+
+    pngle_set_init_callback(pngle, [](pngle_t *pngle, uint32_t w, uint32_t h) {
+        PngBox * box = (PngBox *)pngle_get_user_data(pngle);
+        int16_t  tw, th;
+
+        if (pngle_get_ihdr(pngle)->interlace || (w > INT16_MAX) || (h > INT16_MAX))
+        {
+            box->stop = box->error = true;
+            return;
+        }
+
+        box->image->scaledSize(w, h, tw, th);
+        if (!box->image->startResampling(w, h, tw, th, 1, false))
+            box->stop = box->error = true;
+        else if (box->image->resampler == nullptr)
+            box->stop = true;
+    });
+
+    pngle_set_draw_callback(pngle, [](pngle_t *pngle, uint32_t x, uint32_t /* y */, uint32_t w, uint32_t /* h */, uint8_t rgba[4]) {
+        PngBox * box = (PngBox *)pngle_get_user_data(pngle);
+        Image *  img = box->image;
+
+        if (box->stop)
+            return;
+
+        uint16_t a = rgba[3];
+        uint8_t  g = Image::rgb8Bit(rgba[0], rgba[1], rgba[2]);
+
+        img->resampleRows[x] = (g * a + 255 * (255 - a)) / 255;
+
+        if (x + w >= (uint32_t)img->resampleSrcWidth)
+        {
+            img->resampler->pushRow(img->resampleRows);
+            box->stop = img->resampler->isComplete();
+        }
+    });
+
+    bool ret = url ? feedPng(pngle, readWeb, nullptr, &box.stop) : feedPng(pngle, readFile, p, &box.stop);
+
+    if (url)
+        network_client.closeStream();
 
     pngle_destroy(pngle);
-    free(buff);
-    return ret;
+    stopResampling();
+
+    return box.stop ? !box.error : ret;
 }
 
 // bool Image::drawPngFromWeb(WiFiClient *s, int x, int y, int32_t len, bool dither, bool invert)
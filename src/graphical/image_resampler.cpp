@@ -0,0 +1,103 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Coordinates are in units such that a source pixel is dst pixels wide and
+// an output pixel src pixels wide (for each axis): both images then have
+// the same size, and the area of a source pixel covered by an output pixel
+// is the length of the overlap of their spans.
+//
+// A source row is first resampled horizontally (8.8 fixed point gray
+// levels), then added to the output row it overlaps, weighted by the
+// vertical overlap. When enlarging, a source row covers several output
+// rows: all of them, but the last one, are completed by it.
+
+#include "image_resampler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+ImageResampler::ImageResampler(int16_t src_width, int16_t src_height,
+                               int16_t dst_width, int16_t dst_height,
+                               const Rect & window, RowOutput output, void * context) :
+    src_width(src_width), src_height(src_height),
+    dst_width(dst_width), dst_height(dst_height),
+    window(window), output(output), context(context), src_row(0),
+    row_sums(nullptr), sums(nullptr), out(nullptr)
+{
+    if ((window.w <= 0) || (window.h <= 0)) return;
+
+    uint16_t * r = (uint16_t *) malloc(window.w * sizeof(uint16_t));
+    uint32_t * s = (uint32_t *) calloc(window.w,  sizeof(uint32_t));
+    uint8_t  * o = (uint8_t  *) malloc(window.w);
+
+    if ((r == nullptr) || (s == nullptr) || (o == nullptr)) {
+        free(r);
+        free(s);
+        free(o);
+        return;
+    }
+
+    row_sums = r;
+    sums     = s;
+    out      = o;
+}
+
+ImageResampler::~ImageResampler()
+{
+    free(row_sums);
+    free(sums);
+    free(out);
+}
+
+void ImageResampler::pushRow(const uint8_t * gray)
+{
+    if (!isReady() || (src_row >= src_height)) return;
+
+    uint32_t top    = (uint32_t) src_row * dst_height;
+    uint32_t bottom = top + dst_height;
+
+    src_row++;
+
+    // Output rows overlapped by this source row, limited to the window
+
+    int16_t first = std::max<int32_t>(top / src_height,            window.y);
+    int16_t last  = std::min<int32_t>((bottom - 1) / src_height,   window.y + window.h - 1);
+
+    if (first > last) return;
+
+    for (int16_t i = 0; i < window.w; i++) {
+        uint32_t start = (uint32_t) (window.x + i) * src_width;
+        uint32_t end   = start + src_width;
+        uint32_t pos   = start;
+        uint32_t sum   = 0;
+        int16_t  col   = start / dst_width;
+
+        while (pos < end) {
+            uint32_t next = std::min<uint32_t>((uint32_t) (col + 1) * dst_width, end);
+            sum += gray[col++] * (next - pos);
+            pos  = next;
+        }
+
+        row_sums[i] = ((sum << 8) + (src_width >> 1)) / src_width;
+    }
+
+    uint32_t total = (uint32_t) src_height << 8;
+
+    for (int16_t row = first; row <= last; row++) {
+        uint32_t row_top    = (uint32_t) row * src_height;
+        uint32_t row_bottom = row_top + src_height;
+        uint32_t overlap    = std::min(bottom, row_bottom) - std::max(top, row_top);
+
+        for (int16_t i = 0; i < window.w; i++) sums[i] += row_sums[i] * overlap;
+
+        if (row_bottom <= bottom) {
+            for (int16_t i = 0; i < window.w; i++) {
+                out[i]  = (sums[i] + (total >> 1)) / total;
+                sums[i] = 0;
+            }
+            output(context, row, out);
+        }
+    }
+}
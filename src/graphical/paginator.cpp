@@ -0,0 +1,308 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// A page ends where the layout, limited to the lines of a page, stops. The
+// text is read from the start of the page by chunks: when a chunk holds less
+// than a page of lines, it may be cut in the middle of a line, and is read
+// again with twice its size.
+
+#include "paginator.hpp"
+#include "logging.hpp"
+
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cstring>
+
+constexpr char Paginator::MAGIC[4];
+
+Paginator::Paginator(FontSource & font, int16_t width, int16_t height, TextLayout::Align align) :
+    font(font), width(width), height(height), layout(font, width, align),
+    lines_per_page(1), signature(0), file(nullptr), text_size(0),
+    saved_count(0), complete(false), indexing(false), stop_indexing(false)
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
+}
+
+Paginator::~Paginator()
+{
+    close();
+    vSemaphoreDelete(mutex);
+}
+
+uint32_t Paginator::computeSignature()
+{
+    // FNV-1a hash of what changes where lines are broken: the font identity
+    // covers its kerning and glyphs outside of printable ASCII
+
+    uint32_t hash = 2166136261U;
+
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 16777619U;
+        }
+    };
+
+    mix(width);
+    mix(lines_per_page);
+    mix(font.getYAdvance());
+    mix(font.getIdentity());
+    for (uint32_t codepoint = 0x20; codepoint < 0x7F; codepoint++) mix(font.getAdvance(codepoint));
+
+    return hash;
+}
+
+bool Paginator::open(const char * filename)
+{
+    close();
+
+    if ((file = fopen(filename, "rb")) == nullptr) {
+        ESP_LOGE(TAG, "Unable to open text file %s.", filename);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    text_size = ftell(file);
+
+    lines_per_page = std::max(height / std::max<int16_t>(layout.getLineHeight(), 1), 1);
+    signature      = computeSignature();
+    index_name     = std::string(filename) + ".idx";
+
+    layout.setMaxLines(lines_per_page);
+
+    if (!loadIndex()) {
+        offsets.assign(1, 0);
+        saved_count = 0;
+        complete    = text_size == 0;
+    }
+
+    return true;
+}
+
+void Paginator::close()
+{
+    if (indexing) {
+        stop_indexing = true;
+        while (indexing) vTaskDelay(1);
+    }
+    stop_indexing = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+
+    offsets.clear();
+    buffer.clear();
+    text_size   = 0;
+    saved_count = 0;
+    complete    = false;
+
+    xSemaphoreGive(mutex);
+}
+
+bool Paginator::loadIndex()
+{
+    FILE * f = fopen(index_name.c_str(), "rb");
+    if (f == nullptr) return false;
+
+    Header header;
+
+    bool ok = (fread(&header, sizeof(Header), 1, f) == 1) &&
+              (memcmp(header.magic, MAGIC, 4) == 0) &&
+              (header.version == VERSION) &&
+              (header.lines_per_page == lines_per_page) &&
+              (header.signature == signature) &&
+              (header.text_size <= text_size) &&
+              (header.page_count > 0);
+
+    if (ok) {
+        offsets.resize(header.page_count);
+        ok = (fread(offsets.data(), sizeof(uint32_t), offsets.size(), f) == offsets.size()) &&
+             (offsets[0] == 0);
+    }
+
+    fclose(f);
+
+    if (!ok) return false;
+
+    // The text may have been appended to since: indexing resumes at the
+    // last page
+
+    saved_count = offsets.size();
+    complete    = header.complete && (header.text_size == text_size);
+
+    return true;
+}
+
+void Paginator::saveIndex()
+{
+    // New offsets are appended, and the header rewritten
+
+    FILE * f = fopen(index_name.c_str(), (saved_count == 0) ? "wb" : "r+b");
+
+    if (f == nullptr) {
+        ESP_LOGE(TAG, "Unable to write index file %s.", index_name.c_str());
+        return;
+    }
+
+    Header header;
+
+    memcpy(header.magic, MAGIC, 4);
+    header.version        = VERSION;
+    header.complete       = complete ? 1 : 0;
+    header.lines_per_page = lines_per_page;
+    header.signature      = signature;
+    header.text_size      = text_size;
+    header.page_count     = offsets.size();
+
+    bool ok = (fwrite(&header, sizeof(Header), 1, f) == 1) &&
+              (fseek(f, sizeof(Header) + saved_count * sizeof(uint32_t), SEEK_SET) == 0) &&
+              (fwrite(&offsets[saved_count], sizeof(uint32_t), offsets.size() - saved_count, f) ==
+               offsets.size() - saved_count);
+
+    fclose(f);
+
+    if (ok) saved_count = offsets.size();
+    else ESP_LOGE(TAG, "Unable to write index file %s.", index_name.c_str());
+}
+
+bool Paginator::layoutPage(uint32_t offset, uint32_t & next)
+{
+    uint32_t size = CHUNK_SIZE;
+
+    while (true) {
+        uint32_t length = std::min(size, text_size - offset);
+
+        buffer.resize(length);
+
+        if ((fseek(file, offset, SEEK_SET) != 0) ||
+            (fread(buffer.data(), 1, length, file) != length)) {
+            ESP_LOGE(TAG, "Unable to read text at offset %u.", offset);
+            return false;
+        }
+
+        layout.layout(buffer.data(), length);
+
+        if ((layout.getEnd() < length) || (offset + length >= text_size)) {
+            next = offset + layout.getEnd();
+            return true;
+        }
+
+        size *= 2;
+    }
+}
+
+bool Paginator::addPage()
+{
+    if (complete || (file == nullptr)) return false;
+
+    uint32_t offset = offsets.back();
+    uint32_t next;
+
+    if (!layoutPage(offset, next)) return false;
+
+    if ((next >= text_size) || (next <= offset)) complete = true;
+    else offsets.push_back(next);
+
+    return true;
+}
+
+bool Paginator::buildIndex(uint32_t count)
+{
+    bool done;
+
+    if (file == nullptr) return false;
+
+    for (uint32_t i = 0; (count == 0) || (i < count); i++) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        bool added = addPage();
+        xSemaphoreGive(mutex);
+
+        if (!added || stop_indexing) break;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    saveIndex();
+    done = complete;
+    xSemaphoreGive(mutex);
+
+    return done;
+}
+
+void Paginator::indexingTask(void * param)
+{
+    Paginator * paginator = (Paginator *) param;
+    uint32_t    count     = 0;
+
+    // Stops on a read error: no page added
+
+    while (!paginator->stop_indexing && !paginator->buildIndex(PAGES_PER_STEP)) {
+        uint32_t page_count = paginator->getPageCount();
+        if (page_count == count) break;
+        count = page_count;
+        vTaskDelay(1);
+    }
+
+    paginator->indexing = false;
+    vTaskDelete(nullptr);
+}
+
+bool Paginator::startIndexing(UBaseType_t priority)
+{
+    if (indexing || (file == nullptr) || isComplete()) return true;
+
+    indexing = true;
+
+    if (xTaskCreate(indexingTask, "paginator", 4096, this, priority, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Unable to create the indexing task.");
+        indexing = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool Paginator::drawPage(Graphics & graphics, uint32_t page, int16_t x, int16_t y, uint16_t color)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    // Pages not indexed yet are located on the way
+
+    uint32_t count = offsets.size();
+
+    while ((page >= offsets.size()) && addPage());
+
+    if (offsets.size() > count) saveIndex();
+
+    uint32_t next;
+    bool     ok = (page < offsets.size()) && layoutPage(offsets[page], next);
+
+    if (ok) layout.draw(graphics, x, y, color);
+
+    xSemaphoreGive(mutex);
+
+    return ok;
+}
+
+uint32_t Paginator::getPageCount()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t count = offsets.size();
+    xSemaphoreGive(mutex);
+
+    return count;
+}
+
+bool Paginator::isComplete()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool done = complete;
+    xSemaphoreGive(mutex);
+
+    return done;
+}
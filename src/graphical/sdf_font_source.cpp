@@ -0,0 +1,261 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// A glyph is rasterized by sampling its distance field (bilinear
+// interpolation) at the center of each screen pixel. In 1 bit per pixel,
+// the pixels inside the outline are set. With more bits, the distance to the
+// outline, in screen pixels, gives the coverage: 0.5 pixel inside or more is
+// fully covered. Empty rows and columns are then trimmed.
+
+#include "sdf_font_source.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SDFFontSource::SDFFontSource(const SDFFont * font, uint16_t size, uint8_t bpp, uint32_t cache_size) :
+    font(font), bpp(1), cache_size(cache_size), cached_size(0), hits(0), misses(0)
+{
+    setBpp(bpp);
+    setSize(size);
+}
+
+void SDFFontSource::setSize(uint16_t s)
+{
+    // The distance between lines has to fit in 8 bits
+
+    uint16_t max_size = (255 * font->size) / std::max<uint8_t>(font->yAdvance, 1);
+
+    size      = std::min(std::max<uint16_t>(s, 4), max_size);
+    scale     = (float) size / font->size;
+    y_advance = std::min(lroundf(font->yAdvance * scale), 255L);
+
+    clear();
+    clearAdvances();
+}
+
+void SDFFontSource::setBpp(uint8_t b)
+{
+    bpp = ((b == 2) || (b == 4)) ? b : 1;
+    clear();
+}
+
+void SDFFontSource::setCacheSize(uint32_t bytes)
+{
+    cache_size = bytes;
+    trim(0);
+}
+
+void SDFFontSource::clear()
+{
+    cache.clear();
+    index.clear();
+    cached_size = 0;
+}
+
+void SDFFontSource::trim(uint32_t needed)
+{
+    // The glyph being added is kept even if larger than the cache size
+
+    while (!cache.empty() && (cached_size + needed > cache_size)) {
+        cached_size -= cache.back().data.size();
+        index.erase(cache.back().codepoint);
+        cache.pop_back();
+    }
+}
+
+void SDFFontSource::setBox(const SDFGlyph & g, FontGlyph & glyph)
+{
+    // Screen pixels touched by the distance field. Vertically, the baseline
+    // is at coordinate 1, the bottom edge of row 0 (rows are relative to the
+    // cursor, glyphs sitting on row 0): the scaling is done from there.
+
+    int16_t x0 = floorf(g.xOffset * scale);
+    int16_t y0 = floorf((g.yOffset - 1) * scale) + 1;
+    int16_t x1 = ceilf((g.xOffset + g.width)  * scale);
+    int16_t y1 = ceilf((g.yOffset + g.height - 1) * scale) + 1;
+
+    glyph.bitmap      = nullptr;
+    glyph.bpp         = bpp;
+    glyph.width       = (g.width  > 0) ? x1 - x0 : 0;
+    glyph.height      = (g.height > 0) ? y1 - y0 : 0;
+    glyph.stride_bits = (glyph.width * bpp + 7) & ~7;
+    glyph.x_advance   = lroundf(g.xAdvance * scale / 16);
+    glyph.x_offset    = x0;
+    glyph.y_offset    = y0;
+}
+
+bool SDFFontSource::getMetrics(uint32_t codepoint, FontGlyph & glyph)
+{
+    if ((codepoint < font->first) || (codepoint > font->last)) return false;
+
+    auto it = index.find(codepoint);
+    if (it != index.end()) {
+        glyph = it->second->glyph;
+    }
+    else {
+        setBox(font->glyph[codepoint - font->first], glyph);
+    }
+
+    return true;
+}
+
+uint32_t SDFFontSource::getIdentity()
+{
+    // The range, the sizes and the glyph table. The metrics follow the size
+    // the font is rendered at.
+
+    uint32_t hash = 2166136261U;
+
+    mixIdentity(hash, ((uint32_t) font->first << 16) | font->last);
+    mixIdentity(hash, ((uint32_t) font->size << 24) | ((uint32_t) font->yAdvance << 16) | size);
+    mixIdentity(hash, font->spread);
+
+    for (uint32_t i = 0; i <= (uint32_t) (font->last - font->first); i++) {
+        const SDFGlyph * g = &font->glyph[i];
+        mixIdentity(hash, g->bitmapOffset);
+        mixIdentity(hash, ((uint32_t) g->width << 24) | ((uint32_t) g->height << 16) | g->xAdvance);
+        mixIdentity(hash, ((uint32_t) (uint8_t) g->xOffset << 8) | (uint8_t) g->yOffset);
+    }
+
+    return hash;
+}
+
+bool SDFFontSource::getGlyph(uint32_t codepoint, FontGlyph & glyph)
+{
+    if ((codepoint < font->first) || (codepoint > font->last)) return false;
+
+    auto it = index.find(codepoint);
+    if (it != index.end()) {
+        hits++;
+        if (it->second != cache.begin()) cache.splice(cache.begin(), cache, it->second);
+        glyph = cache.front().glyph;
+        return true;
+    }
+
+    misses++;
+
+    CachedGlyph entry;
+
+    entry.codepoint = codepoint;
+    rasterize(font->glyph[codepoint - font->first], entry);
+
+    trim(entry.data.size());
+
+    cached_size += entry.data.size();
+    cache.push_front(std::move(entry));
+    index[codepoint] = cache.begin();
+
+    CachedGlyph & e = cache.front();
+    e.glyph.bitmap  = e.data.empty() ? nullptr : e.data.data();
+    glyph           = e.glyph;
+
+    return true;
+}
+
+void SDFFontSource::rasterize(const SDFGlyph & g, CachedGlyph & entry)
+{
+    FontGlyph & glyph = entry.glyph;
+
+    setBox(g, glyph);
+
+    int16_t w = glyph.width;
+    int16_t h = glyph.height;
+
+    if ((w == 0) || (h == 0)) return;
+
+    const uint8_t * field = &font->bitmap[g.bitmapOffset];
+    int16_t         fw    = g.width;
+    int16_t         fh    = g.height;
+    uint8_t         max   = (1 << bpp) - 1;
+    float           inv   = 1.0f / scale;
+
+    // Screen pixels per distance unit, for the coverage
+
+    float unit = font->spread * scale / 128.0f;
+
+    // Field position (left or top sample and weight of the next one) of
+    // each screen column and row, clamped to the field edges
+
+    auto position = [&](int16_t screen, int8_t offset, int8_t origin, int16_t count, int16_t & index, float & weight) {
+        float f = (screen - origin + 0.5f) * inv - offset + origin - 0.5f;
+
+        if (f <= 0)              { index = 0;         weight = 0; }
+        else if (f >= count - 1) { index = count - 1; weight = 0; }
+        else                     { index = (int16_t) f; weight = f - index; }
+    };
+
+    std::vector<int16_t> columns(w);
+    std::vector<float>   column_weights(w);
+
+    for (int16_t x = 0; x < w; x++) {
+        position(glyph.x_offset + x, g.xOffset, 0, fw, columns[x], column_weights[x]);
+    }
+
+    std::vector<uint8_t> coverage((size_t) w * h);
+
+    int16_t first_col = w, last_col = -1, first_row = h, last_row = -1;
+
+    for (int16_t y = 0; y < h; y++) {
+        int16_t row;
+        float   wy;
+
+        position(glyph.y_offset + y, g.yOffset, 1, fh, row, wy);
+
+        const uint8_t * top    = &field[row * fw];
+        const uint8_t * bottom = (row + 1 < fh) ? top + fw : top;
+
+        for (int16_t x = 0; x < w; x++) {
+            int16_t i  = columns[x];
+            int16_t i1 = (i + 1 < fw) ? i + 1 : i;
+            float   wx = column_weights[x];
+
+            float d = (top[i]    * (1 - wx) + top[i1]    * wx) * (1 - wy) +
+                      (bottom[i] * (1 - wx) + bottom[i1] * wx) * wy;
+
+            uint8_t c;
+            if (bpp == 1) {
+                c = (d >= 128.0f) ? 1 : 0;
+            }
+            else {
+                float a = (d - 128.0f) * unit + 0.5f;
+                c = (a <= 0) ? 0 : ((a >= 1) ? max : (uint8_t) lroundf(a * max));
+            }
+
+            if (c) {
+                coverage[(size_t) y * w + x] = c;
+                first_col = std::min(first_col, x);
+                last_col  = std::max(last_col,  x);
+                first_row = std::min(first_row, y);
+                last_row  = std::max(last_row,  y);
+            }
+        }
+    }
+
+    if (last_col < 0) {
+        glyph.width = glyph.height = glyph.stride_bits = 0;
+        return;
+    }
+
+    // Trimmed and packed, rows starting on a byte boundary
+
+    glyph.width       = last_col - first_col + 1;
+    glyph.height      = last_row - first_row + 1;
+    glyph.stride_bits = (glyph.width * bpp + 7) & ~7;
+    glyph.x_offset   += first_col;
+    glyph.y_offset   += first_row;
+
+    uint16_t stride = glyph.stride_bits >> 3;
+
+    entry.data.assign((size_t) stride * glyph.height, 0);
+
+    for (int16_t y = 0; y < glyph.height; y++) {
+        const uint8_t * src = &coverage[(size_t) (first_row + y) * w + first_col];
+        uint8_t *       dst = &entry.data[(size_t) y * stride];
+
+        for (int16_t x = 0; x < glyph.width; x++) {
+            uint32_t bit = x * bpp;
+            dst[bit >> 3] |= src[x] << (8 - bpp - (bit & 7));
+        }
+    }
+}
@@ -16,116 +16,213 @@ Distributed as-is; no warranty is given.
 
 #include <math.h>
 
+#include <algorithm>
+
 #include "shapes.hpp"
 
-void Shapes::drawElipse(int rx, int ry, int xc, int yc, int c)
-{
-    float dx, dy, d1, d2, x, y;
-    x = 0;
-    y = ry;
+// Thick lines are rasterized in 16.16 fixed point. A segment is the
+// rectangle (quad) of the given thickness centered on it, filled with spans
+// covering the pixels whose center is inside it. Round caps and joins are
+// discs of the same thickness, whose row half widths are computed once per
+// call. The only floating point operation is the conversion of the
+// thickness.
 
-    d1 = (ry * ry) - (rx * rx * ry) + (0.25 * rx * rx);
-    dx = 2 * ry * ry * x;
-    dy = 2 * rx * rx * y;
+uint32_t Shapes::isqrt(uint64_t v)
+{
+    uint64_t res = 0, bit = (uint64_t)1 << 62;
 
-    while (dx < dy)
+    while (bit > v) bit >>= 2;
+    while (bit)
     {
-        drawPixel(x + xc, y + yc, c);
-        drawPixel(-x + xc, y + yc, c);
-        drawPixel(x + xc, -y + yc, c);
-        drawPixel(-x + xc, -y + yc, c);
-
-        if (d1 < 0)
+        if (v >= res + bit)
         {
-            x++;
-            dx = dx + (2 * ry * ry);
-            d1 = d1 + dx + (ry * ry);
+            v  -= res + bit;
+            res = (res >> 1) + bit;
         }
         else
-        {
-            x++;
-            y--;
-            dx = dx + (2 * ry * ry);
-            dy = dy - (2 * rx * rx);
-            d1 = d1 + dx - dy + (ry * ry);
-        }
+            res >>= 1;
+        bit >>= 2;
     }
+    return res;
+}
 
-    d2 = ((ry * ry) * ((x + 0.5) * (x + 0.5))) + ((rx * rx) * ((y - 1) * (y - 1))) - (rx * rx * ry * ry);
-    while (y >= 0)
+static inline int ceilFx(int64_t v) { return (v + 0xFFFF) >> 16; }
+
+void Shapes::fillQuadFx(const int32_t *vx, const int32_t *vy, int color)
+{
+    struct {
+        int     r0, r1;
+        int32_t ya, xa, dxdy;
+    } edges[4];
+
+    int count = 0, top = INT16_MAX, bottom = INT16_MIN;
+
+    for (int i = 0; i < 4; i++)
     {
-        drawPixel(x + xc, y + yc, c);
-        drawPixel(-x + xc, y + yc, c);
-        drawPixel(x + xc, -y + yc, c);
-        drawPixel(-x + xc, -y + yc, c);
+        int     j  = (i + 1) & 3;
+        int32_t xa = vx[i], ya = vy[i], xb = vx[j], yb = vy[j];
 
-        if (d2 > 0)
+        if (ya == yb) continue;
+        if (ya > yb)
         {
-            y--;
-            dy = dy - (2 * rx * rx);
-            d2 = d2 + (rx * rx) - dy;
+            std::swap(xa, xb);
+            std::swap(ya, yb);
         }
-        else
+
+        // Rows whose center is in [ya, yb)
+
+        int r0 = ceilFx(ya), r1 = ceilFx(yb) - 1;
+        if (r0 > r1) continue;
+
+        edges[count].r0   = r0;
+        edges[count].r1   = r1;
+        edges[count].ya   = ya;
+        edges[count].xa   = xa;
+        edges[count].dxdy = ((int64_t)(xb - xa) * 65536) / (yb - ya);
+        count++;
+
+        if (r0 < top   ) top    = r0;
+        if (r1 > bottom) bottom = r1;
+    }
+
+    Rect clip = getClipRect();
+
+    if (top < clip.y) top = clip.y;
+    if (bottom >= clip.y + clip.h) bottom = clip.y + clip.h - 1;
+
+    for (int r = top; r <= bottom; r++)
+    {
+        int64_t xl = INT64_MAX, xr = INT64_MIN;
+
+        for (int i = 0; i < count; i++)
         {
-            y--;
-            x++;
-            dx = dx + (2 * ry * ry);
-            dy = dy - (2 * rx * rx);
-            d2 = d2 + dx - dy + (rx * rx);
+            if ((r < edges[i].r0) || (r > edges[i].r1)) continue;
+            int64_t x = edges[i].xa + (((int64_t)edges[i].dxdy * ((int64_t)r * 65536 - edges[i].ya)) >> 16);
+            if (x < xl) xl = x;
+            if (x > xr) xr = x;
         }
+        if (xl > xr) continue;
+
+        int x0 = ceilFx(xl), x1 = ceilFx(xr) - 1;
+        if (x0 <= x1) writeFastHLine(x0, r, x1 - x0 + 1, color);
     }
 }
 
-void Shapes::fillElipse(int rx, int ry, int xc, int yc, int c)
+void Shapes::thickSegment(int x1, int y1, int x2, int y2, int32_t half, bool extend, int color)
 {
-    int hh = ry * ry;
-    int ww = rx * rx;
-    int hhww = hh * ww;
-    int x0 = rx;
-    int dx = 0;
+    int32_t dx = x2 - x1, dy = y2 - y1;
+
+    if ((dx == 0) && (dy == 0)) dx = 1; // Single point: horizontal direction
+
+    // Length, perpendicular offset and (if extend) half pixel extension,
+    // all 16.16
 
-    for (int x = -rx; x <= rx; x++)
-        drawPixel(xc + x, yc, c);
+    int64_t len = isqrt(((uint64_t)((int64_t)dx * dx + (int64_t)dy * dy)) << 32);
+    int32_t ox  = (int32_t)(-(int64_t)dy * half * 65536 / len);
+    int32_t oy  = (int32_t)( (int64_t)dx * half * 65536 / len);
+    int32_t ex  = extend ? (int32_t)(((int64_t)dx << 31) / len) : 0;
+    int32_t ey  = extend ? (int32_t)(((int64_t)dy << 31) / len) : 0;
 
-    for (int y = 1; y <= ry; y++)
+    int32_t ax = x1 * 65536 - ex, ay = y1 * 65536 - ey;
+    int32_t bx = x2 * 65536 + ex, by = y2 * 65536 + ey;
+
+    int32_t vx[4] = { ax + ox, bx + ox, bx - ox, ax - ox };
+    int32_t vy[4] = { ay + oy, by + oy, by - oy, ay - oy };
+
+    fillQuadFx(vx, vy, color);
+}
+
+int16_t * Shapes::discHalfWidths(int32_t half, int16_t *buffer, int & radius)
+{
+    radius = half >> 16;
+
+    int16_t *halfWidths = (radius <= MAX_DISC_RADIUS) ? buffer : new int16_t[radius + 1];
+
+    for (int dy = 0; dy <= radius; dy++)
+        halfWidths[dy] = isqrt((uint64_t)half * half - ((uint64_t)dy * dy << 32)) >> 16;
+
+    return halfWidths;
+}
+
+void Shapes::fillDisc(int xc, int yc, const int16_t *halfWidths, int radius, int color)
+{
+    writeFastHLine(xc - halfWidths[0], yc, 2 * halfWidths[0] + 1, color);
+    for (int dy = 1; dy <= radius; dy++)
     {
-        int x1 = x0 - (dx - 1);
-        for (; x1 > 0; x1--)
-            if (x1 * x1 * hh + y * y * ww <= hhww)
-                break;
-        dx = x0 - x1;
-        x0 = x1;
-
-        for (int x = -x0; x <= x0; x++)
-        {
-            drawPixel(xc + x, yc - y, c);
-            drawPixel(xc + x, yc + y, c);
-        }
+        writeFastHLine(xc - halfWidths[dy], yc - dy, 2 * halfWidths[dy] + 1, color);
+        writeFastHLine(xc - halfWidths[dy], yc + dy, 2 * halfWidths[dy] + 1, color);
     }
 }
 
 void Shapes::drawThickLine(int x1, int y1, int x2, int y2, int color, float thickness)
 {
-    float deg = atan2f((float)(y2 - y1), (float)(x2 - x1));
+    if (thickness < 1.0f)
+    {
+        drawLine(x1, y1, x2, y2, color);
+        return;
+    }
 
-    float l1 = tan(deg);
+    // Butt ends, both end points included as with drawLine()
 
-    float degShift = (l1 < 0 ? M_PI_2 : -M_PI_2);
+    startWrite();
+    thickSegment(x1, y1, x2, y2, (int32_t)(thickness * 32768.0f), true, color);
+    endWrite();
+}
 
-    int x3 = (int)round((float)x1 + thickness / 2.0 * cos(deg + degShift));
-    int y3 = (int)round((float)y1 + thickness / 2.0 * sin(deg + degShift));
+void Shapes::drawCapsule(int x1, int y1, int x2, int y2, int color, float thickness)
+{
+    if (thickness < 1.0f)
+    {
+        drawLine(x1, y1, x2, y2, color);
+        return;
+    }
 
-    int x4 = (int)round((float)x2 + thickness / 2.0 * cos(deg + degShift));
-    int y4 = (int)round((float)y2 + thickness / 2.0 * sin(deg + degShift));
+    int32_t half = (int32_t)(thickness * 32768.0f);
+    int16_t buffer[MAX_DISC_RADIUS + 1];
+    int     radius;
+    int16_t *halfWidths = discHalfWidths(half, buffer, radius);
 
-    x1 = (int)round((float)x1 + thickness / 2.0 * cos(deg - degShift));
-    y1 = (int)round((float)y1 + thickness / 2.0 * sin(deg - degShift));
+    startWrite();
+    thickSegment(x1, y1, x2, y2, half, false, color);
+    fillDisc(x1, y1, halfWidths, radius, color);
+    fillDisc(x2, y2, halfWidths, radius, color);
+    endWrite();
+
+    if (halfWidths != buffer) delete [] halfWidths;
+}
 
-    x2 = (int)round((float)x2 + thickness / 2.0 * cos(deg - degShift));
-    y2 = (int)round((float)y2 + thickness / 2.0 * sin(deg - degShift));
+void Shapes::drawThickPolyline(int *x, int *y, int n, int color, float thickness)
+{
+    if (n <= 0) return;
+
+    if (thickness < 1.0f)
+    {
+        for (int i = 0; i + 1 < n; i++)
+            drawLine(x[i], y[i], x[i + 1], y[i + 1], color);
+        if (n == 1) drawPixel(x[0], y[0], color);
+        return;
+    }
+
+    // Each vertex gets a single disc: the round join between its two
+    // segments, or the round cap at the ends. Consecutive duplicated
+    // vertices are skipped.
+
+    int32_t half = (int32_t)(thickness * 32768.0f);
+    int16_t buffer[MAX_DISC_RADIUS + 1];
+    int     radius;
+    int16_t *halfWidths = discHalfWidths(half, buffer, radius);
+
+    startWrite();
+    fillDisc(x[0], y[0], halfWidths, radius, color);
+    for (int i = 1; i < n; i++)
+    {
+        if ((x[i] == x[i - 1]) && (y[i] == y[i - 1])) continue;
+        thickSegment(x[i - 1], y[i - 1], x[i], y[i], half, false, color);
+        fillDisc(x[i], y[i], halfWidths, radius, color);
+    }
+    endWrite();
 
-    fillTriangle(x1, y1, x2, y2, x3, y3, color);
-    fillTriangle(x2, y2, x4, y4, x3, y3, color);
+    if (halfWidths != buffer) delete [] halfWidths;
 }
 
 void Shapes::drawGradientLine(int x1, int y1, int x2, int y2, int color1, int color2, float thickness)
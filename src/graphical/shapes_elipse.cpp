@@ -0,0 +1,297 @@
+/*
+shapes_elipse.cpp
+Inkplate 6 Arduino library
+David Zovko, Borna Biro, Denis Vajak, Zvonimir Haramustek @ e-radionica.com
+September 24, 2020
+https://github.com/e-radionicacom/Inkplate-6-Arduino-library
+
+For support, please reach over forums: forum.e-radionica.com/en
+For more info about the product, please check: www.inkplate.io
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+Please review the LICENSE file included with this example.
+If you have any questions about licensing, please contact techsupport@e-radionica.com
+Distributed as-is; no warranty is given.
+*/
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "shapes.hpp"
+
+// All integer ellipse rasterization.
+//
+// drawElipse() is the midpoint algorithm with its decision variables
+// scaled by 4, such that the 0.25 and 0.5 terms become integers. Pixels
+// are gathered in horizontal runs in the first region (where x moves
+// faster than y) and in vertical runs in the second one, and written with
+// writeFastHLine() / writeFastVLine().
+//
+// Filled shapes (fillElipse(), drawThickElipse() and drawElipseArc()) are
+// computed a row at a time, for the rows inside the clipping rectangle
+// only: for each row, the half width of the ellipse is the largest x such
+// that x^2 * ry^2 + y^2 * rx^2 <= rx^2 * ry^2 (an integer square root for
+// the first row, then decreasing from the previous row's). A ring is
+// the difference between the outer and inner (radii reduced by the
+// thickness) ellipses. An arc is a ring limited to an angular sector,
+// whose intersection with a row is computed from the two half-planes
+// bounded by the sector's rays.
+//
+// Tolerance: drawElipse() gives the same pixels as the previous floating
+// point version for radii up to 200. Above, the single precision float
+// computation was losing precision and some pixels may now differ, the new
+// ones being always within one pixel of the true curve. fillElipse() gives
+// the same pixels as before, except for large ellipses where the previous
+// 32 bit computation was overflowing. A ring of thickness 1 follows the same
+// curve as drawElipse(), but can differ from it by one pixel in places as
+// it is derived from the filled shapes.
+
+static inline int64_t floorDiv(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return ((a % b != 0) && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// Restrict [lo, hi] to the values of x such that a * x <= b
+
+static inline void halfLine(int64_t a, int64_t b, int & lo, int & hi)
+{
+    if (a > 0)
+        hi = std::min<int64_t>(hi, floorDiv(b, a));
+    else if (a < 0)
+        lo = std::max<int64_t>(lo, -floorDiv(-b, a));
+    else if (b < 0)
+        lo = INT16_MAX, hi = INT16_MIN;
+}
+
+void Shapes::drawElipse(int rx, int ry, int xc, int yc, int c)
+{
+    int64_t rx2 = (int64_t)rx * rx;
+    int64_t ry2 = (int64_t)ry * ry;
+
+    int x = 0, y = ry;
+
+    int64_t dx = 0;
+    int64_t dy = 2 * rx2 * y;
+    int64_t d1 = 4 * ry2 - 4 * rx2 * ry + rx2;
+
+    startWrite();
+
+    // Region 1: horizontal runs
+
+    int run = x;
+    while (dx < dy)
+    {
+        if (d1 < 0)
+        {
+            x++;
+            dx = dx + (2 * ry2);
+            d1 = d1 + 4 * (dx + ry2);
+        }
+        else
+        {
+            writeFastHLine(xc + run, yc + y, x - run + 1, c);
+            writeFastHLine(xc - x,   yc + y, x - run + 1, c);
+            writeFastHLine(xc + run, yc - y, x - run + 1, c);
+            writeFastHLine(xc - x,   yc - y, x - run + 1, c);
+            x++;
+            y--;
+            run = x;
+            dx = dx + (2 * ry2);
+            dy = dy - (2 * rx2);
+            d1 = d1 + 4 * (dx - dy + ry2);
+        }
+    }
+    if (run < x)
+    {
+        writeFastHLine(xc + run,   yc + y, x - run, c);
+        writeFastHLine(xc - x + 1, yc + y, x - run, c);
+        writeFastHLine(xc + run,   yc - y, x - run, c);
+        writeFastHLine(xc - x + 1, yc - y, x - run, c);
+    }
+
+    // Region 2: vertical runs
+
+    int64_t d2 = ry2 * (2 * x + 1) * (2 * x + 1) + 4 * rx2 * (int64_t)(y - 1) * (y - 1) - 4 * rx2 * ry2;
+
+    run = y;
+    while (y >= 0)
+    {
+        if (d2 > 0)
+        {
+            y--;
+            dy = dy - (2 * rx2);
+            d2 = d2 + 4 * (rx2 - dy);
+        }
+        else
+        {
+            writeFastVLine(xc + x, yc + y,   run - y + 1, c);
+            writeFastVLine(xc - x, yc + y,   run - y + 1, c);
+            writeFastVLine(xc + x, yc - run, run - y + 1, c);
+            writeFastVLine(xc - x, yc - run, run - y + 1, c);
+            y--;
+            x++;
+            run = y;
+            dx = dx + (2 * ry2);
+            dy = dy - (2 * rx2);
+            d2 = d2 + 4 * (dx - dy + rx2);
+        }
+    }
+    if (run >= 0)
+    {
+        writeFastVLine(xc + x, yc,       run + 1, c);
+        writeFastVLine(xc - x, yc,       run + 1, c);
+        writeFastVLine(xc + x, yc - run, run + 1, c);
+        writeFastVLine(xc - x, yc - run, run + 1, c);
+    }
+
+    endWrite();
+}
+
+void Shapes::fillElipse(int rx, int ry, int xc, int yc, int c)
+{
+    elipseRows(rx, ry, xc, yc, 0, nullptr, c);
+}
+
+void Shapes::drawThickElipse(int rx, int ry, int xc, int yc, int thickness, int c)
+{
+    elipseRows(rx, ry, xc, yc, std::max(thickness, 1), nullptr, c);
+}
+
+void Shapes::drawElipseArc(int rx, int ry, int xc, int yc, int startAngle, int endAngle, int thickness, int c)
+{
+    int sweep = endAngle - startAngle;
+
+    if (sweep >= 360 || sweep <= -360)
+    {
+        elipseRows(rx, ry, xc, yc, std::max(thickness, 1), nullptr, c);
+        return;
+    }
+
+    sweep = ((sweep % 360) + 360) % 360;
+    if (sweep == 0) return;
+
+    // The two rays, as 1.12 fixed point direction vectors. These are the
+    // only trigonometric computations, done once per call.
+
+    ElipseSector sector;
+    float        a0 = startAngle * (float)M_PI / 180.0f;
+    float        a1 = (startAngle + sweep) * (float)M_PI / 180.0f;
+
+    sector.d0x  = lroundf(cosf(a0) * 4096.0f);
+    sector.d0y  = lroundf(sinf(a0) * 4096.0f);
+    sector.d1x  = lroundf(cosf(a1) * 4096.0f);
+    sector.d1y  = lroundf(sinf(a1) * 4096.0f);
+    sector.wide = sweep > 180;
+
+    elipseRows(rx, ry, xc, yc, std::max(thickness, 1), &sector, c);
+}
+
+void Shapes::elipseSpan(int x0, int x1, int y, int xc, int yc, const ElipseSector * sector, int c)
+{
+    if (x0 > x1) return;
+
+    if (sector == nullptr)
+    {
+        writeFastHLine(xc + x0, yc + y, x1 - x0 + 1, c);
+        return;
+    }
+
+    // A sector of at most 180 degrees is the intersection of the half-planes
+    // on the inner side of its two rays: cross(d0, p) >= 0 and cross(p, d1) >= 0.
+    // A wider sector is the complement of the intersection of the two
+    // opposite (strict) half-planes. On a row, each is an interval.
+
+    int lo = INT16_MIN, hi = INT16_MAX;
+
+    if (!sector->wide)
+    {
+        halfLine( sector->d0y,  (int64_t)sector->d0x * y, lo, hi);
+        halfLine(-sector->d1y, -(int64_t)sector->d1x * y, lo, hi);
+
+        lo = std::max(lo, x0);
+        hi = std::min(hi, x1);
+        if (lo <= hi) writeFastHLine(xc + lo, yc + y, hi - lo + 1, c);
+    }
+    else
+    {
+        halfLine(-sector->d0y, -(int64_t)sector->d0x * y - 1, lo, hi);
+        halfLine( sector->d1y,  (int64_t)sector->d1x * y - 1, lo, hi);
+
+        if (lo > hi)
+        {
+            writeFastHLine(xc + x0, yc + y, x1 - x0 + 1, c);
+            return;
+        }
+
+        int e = std::min(lo - 1, x1);
+        if (x0 <= e) writeFastHLine(xc + x0, yc + y, e - x0 + 1, c);
+        int s = std::max(hi + 1, x0);
+        if (s <= x1) writeFastHLine(xc + s, yc + y, x1 - s + 1, c);
+    }
+}
+
+void Shapes::elipseRows(int rx, int ry, int xc, int yc, int thickness, const ElipseSector * sector, int c)
+{
+    if ((rx < 0) || (ry < 0)) return;
+
+    // Rows inside the clipping rectangle: yc + y for y in [below0, below1],
+    // yc - y for y in [above0, above1]. Only the rows from the first to the
+    // last visible one are computed.
+
+    Rect clip = getClipRect();
+
+    int below0 = clip.y - yc, below1 = clip.y + clip.h - 1 - yc;
+    int above0 = yc - (clip.y + clip.h - 1), above1 = yc - clip.y;
+
+    int ymin = std::max(0, std::min(below0, above0));
+    int ymax = std::min(ry, std::max(below1, above1));
+
+    if (ymin > ymax) return;
+
+    int64_t hh   = (int64_t)ry * ry;
+    int64_t ww   = (int64_t)rx * rx;
+    int64_t hhww = hh * ww;
+
+    // Inner ellipse, if any
+
+    int     irx = rx - thickness, iry = ry - thickness;
+    bool    hole = (thickness > 0) && (irx > 0) && (iry > 0);
+    int64_t ihh = (int64_t)iry * iry;
+    int64_t iww = (int64_t)irx * irx;
+    int64_t ihhww = ihh * iww;
+
+    // Half widths of the outer and inner ellipses on the current row, from
+    // their square at the first row. They only decrease when moving away
+    // from the center row.
+
+    int64_t yy = (int64_t)ymin * ymin;
+    int     xo = (hh > 0) ? isqrt((hhww - yy * ww) / hh) : rx;
+    int     xi = (hole && (ymin <= iry)) ? isqrt((ihhww - yy * iww) / ihh) : irx;
+
+    startWrite();
+
+    for (int y = ymin; y <= ymax; y++)
+    {
+        while ((xo > 0) && ((int64_t)xo * xo * hh + (int64_t)y * y * ww > hhww)) xo--;
+
+        bool below = (y >= below0) && (y <= below1);
+        bool above = (y > 0) && (y >= above0) && (y <= above1);
+
+        int first = -xo, last = xo; // Span left of the hole, or whole row
+
+        if (hole && (y <= iry))
+        {
+            while ((xi > 0) && ((int64_t)xi * xi * ihh + (int64_t)y * y * iww > ihhww)) xi--;
+            last = -xi - 1;
+            if (below) elipseSpan(xi + 1, xo, y, xc, yc, sector, c);
+            if (above) elipseSpan(xi + 1, xo, -y, xc, yc, sector, c);
+        }
+
+        if (below) elipseSpan(first, last, y, xc, yc, sector, c);
+        if (above) elipseSpan(first, last, -y, xc, yc, sector, c);
+    }
+
+    endWrite();
+}
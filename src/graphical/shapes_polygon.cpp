@@ -16,234 +16,129 @@ Distributed as-is; no warranty is given.
 
 #include "shapes.hpp"
 
-void Shapes::initedgeTable()
-{
-    int i;
-    for (i = 0; i < maxHt; i++)
-        edgeTable[i].countEdgeBucket = 0;
-    activeEdgeTuple.countEdgeBucket = 0;
-}
+#include <algorithm>
+
+// Sparse active edge table scanline filler.
+//
+// Edges are kept in a single array of at most n entries, sorted by their
+// first scanline. The active edges (the ones crossing the current
+// scanline) are kept at the front of a second array, in x order. As their
+// x positions move by small amounts from one scanline to the next, the
+// insertion sort that keeps them ordered is usually a single pass. Each
+// edge is active from its top scanline up to, but excluding, its bottom
+// one, such that a vertex shared by two edges is only counted once. Spans
+// are filled with the even-odd rule.
 
-void Shapes::insertionSort(edgeTableTuple *ett)
+void Shapes::drawPolygon(int *x, int *y, int n, int color)
 {
-    int i, j;
-    EdgeBucket temp;
-
-    for (i = 1; i < ett->countEdgeBucket; i++)
-    {
-        temp.ymax = ett->buckets[i].ymax;
-        temp.xofymin = ett->buckets[i].xofymin;
-        temp.slopeinverse = ett->buckets[i].slopeinverse;
-        j = i - 1;
-
-        while ((temp.xofymin < ett->buckets[j].xofymin) && (j >= 0))
-        {
-            ett->buckets[j + 1].ymax = ett->buckets[j].ymax;
-            ett->buckets[j + 1].xofymin = ett->buckets[j].xofymin;
-            ett->buckets[j + 1].slopeinverse = ett->buckets[j].slopeinverse;
-            j = j - 1;
-        }
-        ett->buckets[j + 1].ymax = temp.ymax;
-        ett->buckets[j + 1].xofymin = temp.xofymin;
-        ett->buckets[j + 1].slopeinverse = temp.slopeinverse;
-    }
+    for (int i = 0; i < n; ++i)
+        drawLine(x[i], y[i], x[(i + 1) % n], y[(i + 1) % n], color);
 }
 
-void Shapes::storeEdgeInTuple(edgeTableTuple *receiver, int ym, int xm, float slopInv)
+void Shapes::fillPolygon(int *x, int *y, int n, int color)
 {
-    (receiver->buckets[(receiver)->countEdgeBucket]).ymax = ym;
-    (receiver->buckets[(receiver)->countEdgeBucket]).xofymin = (float)xm;
-    (receiver->buckets[(receiver)->countEdgeBucket]).slopeinverse = slopInv;
-
-    insertionSort(receiver);
-
-    (receiver->countEdgeBucket)++;
+    drawPolygon(x, y, n, color);
+    fillPolygonSpans(x, y, n, color);
 }
 
-void Shapes::storeEdgeInTable(int x1, int y1, int x2, int y2)
+void Shapes::fillPolygonSpans(int *x, int *y, int n, int color)
 {
-    float m, minv;
-    int ymaxTS, xwithyminTS, scanline; // ts stands for to store
+    if (n < 3) return;
 
-    if (x2 == x1)
-    {
-        minv = 0.000000;
-    }
-    else
-    {
-        m = ((float)(y2 - y1)) / ((float)(x2 - x1));
+    PolygonEdge *  edges = new PolygonEdge[n];
+    PolygonEdge ** active = new PolygonEdge *[n];
 
-        if (y2 == y1)
-            return;
+    int count = 0;
+    int top = INT16_MAX, bottom = INT16_MIN;
 
-        minv = (float)1.0 / m;
-    }
+    startWrite();
 
-    if (y1 > y2)
-    {
-        scanline = y2;
-        ymaxTS = y1;
-        xwithyminTS = x2;
-    }
-    else
+    for (int i = 0; i < n; ++i)
     {
-        scanline = y1;
-        ymaxTS = y2;
-        xwithyminTS = x1;
-    }
-    storeEdgeInTuple(&edgeTable[scanline], ymaxTS, xwithyminTS, minv);
-}
+        int x1 = x[i], y1 = y[i];
+        int x2 = x[(i + 1) % n], y2 = y[(i + 1) % n];
 
-void Shapes::removeEdgeByYmax(edgeTableTuple *tup, int yy)
-{
-    int i, j;
-    for (i = 0; i < tup->countEdgeBucket; i++)
-    {
-        if (tup->buckets[i].ymax == yy)
+        if (y1 == y2) continue; // Horizontal edges are part of the outline only
+
+        if (y1 > y2)
         {
-            for (j = i; j < tup->countEdgeBucket - 1; j++)
-            {
-                tup->buckets[j].ymax = tup->buckets[j + 1].ymax;
-                tup->buckets[j].xofymin = tup->buckets[j + 1].xofymin;
-                tup->buckets[j].slopeinverse = tup->buckets[j + 1].slopeinverse;
-            }
-            tup->countEdgeBucket--;
-            i--;
+            std::swap(x1, x2);
+            std::swap(y1, y2);
         }
-    }
-}
 
-void Shapes::updatexbyslopeinv(edgeTableTuple *tup)
-{
-    int i;
+        PolygonEdge & e = edges[count++];
 
-    for (i = 0; i < tup->countEdgeBucket; i++)
-    {
-        (tup->buckets[i]).xofymin = (tup->buckets[i]).xofymin + (tup->buckets[i]).slopeinverse;
+        e.ymin = y1;
+        e.ymax = y2;
+        e.x    = (int64_t) x1 * 65536;
+        e.dx   = ((int64_t)(x2 - x1) * 65536) / (y2 - y1);
+
+        if (y1 < top   ) top    = y1;
+        if (y2 > bottom) bottom = y2;
     }
-}
 
-void Shapes::scanlineFill(uint8_t c)
-{
-    int i, j, x1, ymax1, x2, ymax2, FillFlag = 0, coordCount;
+    std::sort(edges, edges + count, [](const PolygonEdge & a, const PolygonEdge & b) { return a.ymin < b.ymin; });
+
+    // Only the scanlines inside the clipping rectangle are scanned
 
-    for (i = 0; i < maxHt; i++)
+    Rect clip = getClipRect();
+
+    if (top < clip.y) top = clip.y;
+    if (bottom > clip.y + clip.h) bottom = clip.y + clip.h;
+
+    int next        = 0; // Next edge to become active
+    int activeCount = 0;
+
+    for (int yy = top; yy < bottom; yy++)
     {
-        for (j = 0; j < edgeTable[i].countEdgeBucket; j++)
-            storeEdgeInTuple(&activeEdgeTuple, edgeTable[i].buckets[j].ymax, edgeTable[i].buckets[j].xofymin,
-                             edgeTable[i].buckets[j].slopeinverse);
-
-        removeEdgeByYmax(&activeEdgeTuple, i);
-        insertionSort(&activeEdgeTuple);
-
-        j = 0;
-        FillFlag = 0;
-        coordCount = 0;
-        x1 = 0;
-        x2 = 0;
-        ymax1 = 0;
-        ymax2 = 0;
-        while (j < activeEdgeTuple.countEdgeBucket)
+        // Retire the edges ending on this scanline, advance the others
+
+        int j = 0;
+        for (int i = 0; i < activeCount; i++)
         {
-            if (coordCount % 2 == 0)
+            if (active[i]->ymax > yy)
             {
-                x1 = (int)(activeEdgeTuple.buckets[j].xofymin);
-                ymax1 = activeEdgeTuple.buckets[j].ymax;
-                if (x1 == x2)
-                {
-                    if (((x1 == ymax1) && (x2 != ymax2)) || ((x1 != ymax1) && (x2 == ymax2)))
-                    {
-                        x2 = x1;
-                        ymax2 = ymax1;
-                    }
-
-                    else
-                    {
-                        coordCount++;
-                    }
-                }
-                else
-                {
-                    coordCount++;
-                }
+                active[i]->x += active[i]->dx;
+                active[j++] = active[i];
             }
-            else
-            {
-                x2 = (int)activeEdgeTuple.buckets[j].xofymin;
-                ymax2 = activeEdgeTuple.buckets[j].ymax;
-
-                FillFlag = 0;
-                if (x1 == x2)
-                {
-                    if (((x1 == ymax1) && (x2 != ymax2)) || ((x1 != ymax1) && (x2 == ymax2)))
-                    {
-                        x1 = x2;
-                        ymax1 = ymax2;
-                    }
-                    else
-                    {
-                        coordCount++;
-                        FillFlag = 1;
-                    }
-                }
-                else
-                {
-                    coordCount++;
-                    FillFlag = 1;
-                }
-
-                if (FillFlag)
-                {
-                    // Serial.println(x1);
-                    // Serial.println(x2);
-                    // Serial.println();
-                    drawLine(x1, i, x2, i, c);
-                }
-            }
-
-            j++;
         }
-        updatexbyslopeinv(&activeEdgeTuple);
-    }
-}
+        activeCount = j;
 
-void Shapes::drawPolygon(int *x, int *y, int n, int color)
-{
-    for (int i = 0; i < n; ++i)
-        drawLine(x[i], y[i], x[(i + 1) % n], y[(i + 1) % n], color);
-}
-
-void Shapes::fillPolygon(int *x, int *y, int n, int color)
-{
-    edgeTable = (edgeTableTuple *) malloc(maxHt * sizeof(edgeTableTuple));
-    initedgeTable();
-
-    int count = 0, x1, y1, x2, y2;
+        // Add the edges starting on (or, at the first scanline, above) this
+        // scanline, positioned on it
 
-    x1 = y1 = x2 = y2 = 0;
-    
-    for (int i = 0; i < n + 1; ++i)
-    {
-        count++;
-        if (count > 2)
+        while ((next < count) && (edges[next].ymin <= yy))
         {
-            x1 = x2;
-            y1 = y2;
-            count = 2;
+            PolygonEdge * e = &edges[next++];
+            if (e->ymax <= yy) continue;
+            e->x += (int64_t) e->dx * (yy - e->ymin);
+            active[activeCount++] = e;
         }
-        if (count == 1)
+
+        // Keep the active edges sorted by x
+
+        for (int i = 1; i < activeCount; i++)
         {
-            x1 = x[i % n];
-            y1 = y[i % n];
+            PolygonEdge * e = active[i];
+            int k = i - 1;
+            while ((k >= 0) && (active[k]->x > e->x))
+            {
+                active[k + 1] = active[k];
+                k--;
+            }
+            active[k + 1] = e;
         }
-        else
+
+        for (int i = 0; i + 1 < activeCount; i += 2)
         {
-            x2 = x[i % n];
-            y2 = y[i % n];
-            drawLine(x1, y1, x2, y2, color);
-            storeEdgeInTable(x1, y1, x2, y2);
+            int64_t x1 = std::max<int64_t>((active[i    ]->x + 0x8000) >> 16, clip.x);
+            int64_t x2 = std::min<int64_t>((active[i + 1]->x + 0x8000) >> 16, clip.x + clip.w - 1);
+            if (x1 <= x2) writeFastHLine(x1, yy, x2 - x1 + 1, color);
         }
     }
-    scanlineFill(color);
-    free(edgeTable);
-}
\ No newline at end of file
+
+    endWrite();
+
+    delete [] active;
+    delete [] edges;
+}
@@ -0,0 +1,256 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// The measuring pass decodes each character once. The width of the current
+// line is accumulated with the advance table; the position and width at the
+// last space (the last break opportunity) are kept, such that an overflowing
+// line is ended there without going back over its characters.
+
+#include "text_layout.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Next code point of a UTF-8 string. Malformed sequences are skipped.
+
+static uint32_t nextCodepoint(const char * text, uint32_t length, uint32_t & pos)
+{
+    while (pos < length) {
+        uint8_t  c = text[pos++];
+        uint8_t  count;
+        uint32_t codepoint;
+
+        if      (c < 0x80)           return c;
+        else if ((c & 0xE0) == 0xC0) { codepoint = c & 0x1F; count = 1; }
+        else if ((c & 0xF0) == 0xE0) { codepoint = c & 0x0F; count = 2; }
+        else if ((c & 0xF8) == 0xF0) { codepoint = c & 0x07; count = 3; }
+        else continue;
+
+        while (count && (pos < length) && ((text[pos] & 0xC0) == 0x80)) {
+            codepoint = (codepoint << 6) | (text[pos++] & 0x3F);
+            count--;
+        }
+        if (count == 0) return codepoint;
+    }
+    return 0;
+}
+
+TextLayout::TextLayout(FontSource & font, int16_t width, Align align) :
+    font(font), width(width), align(align), line_height(font.getYAdvance()), max_lines(0),
+    text(nullptr), end(0)
+{
+}
+
+uint16_t TextLayout::layout(const char * txt, uint32_t length)
+{
+    text = txt;
+    end  = length;
+    lines.clear();
+
+    Line     line       = { 0, 0, 0, 0, false };
+    int32_t  line_width = 0;  // Up to the current position, spaces included
+    uint16_t spaces     = 0;
+    uint32_t previous   = 0;  // Code point, for kerning, 0 at the start of a line
+
+    // Last break opportunity: where the line ends if broken there, and
+    // where the next one starts
+
+    bool     can_break    = false;
+    uint32_t break_end    = 0;
+    int32_t  break_width  = 0;
+    uint16_t break_spaces = 0;
+    uint32_t next_start   = 0;
+    int32_t  next_offset  = 0;  // Width before the next line start
+    uint16_t next_spaces  = 0;
+
+    auto end_line = [&](uint32_t end, int32_t w, uint16_t s, bool last) {
+        line.end    = end;
+        line.width  = w;
+        line.spaces = s;
+        line.last   = last;
+        lines.push_back(line);
+    };
+
+    auto start_line = [&](uint32_t start) {
+        line       = { start, start, 0, 0, false };
+        line_width = 0;
+        spaces     = 0;
+        previous   = 0;
+        can_break  = false;
+    };
+
+    // With a limit on the count of lines, the layout stops at the first
+    // character that doesn't belong to them
+
+    auto full = [&]() {
+        return (max_lines > 0) && (lines.size() >= max_lines);
+    };
+
+    uint32_t pos     = 0;
+    bool     stopped = false;
+
+    while (pos < length) {
+        uint32_t start     = pos;
+        uint32_t codepoint = nextCodepoint(text, length, pos);
+
+        if (codepoint == 0) break;
+
+        if (codepoint == '\n') {
+            if ((stopped = full())) break;
+            if (previous == ' ')
+                end_line(line.end, break_width, break_spaces, true);
+            else
+                end_line(line.end, line_width, spaces, true);
+            start_line(pos);
+            continue;
+        }
+
+        int16_t advance = font.getAdvance(codepoint);
+        if (advance < 0) continue;  // Not in the font
+
+        if (codepoint == ' ') {
+            if (previous != ' ') {
+                can_break    = line.end > line.start;
+                break_end    = line.end;
+                break_width  = line_width;
+                break_spaces = spaces;
+            }
+            line_width += advance;
+            spaces++;
+            next_start  = pos;
+            next_offset = line_width;
+            next_spaces = spaces;
+            previous    = codepoint;
+            continue;
+        }
+
+        // No kerning after a space: the width of a word doesn't depend on
+        // what precedes it
+
+        int16_t kerning = (previous && (previous != ' ')) ? font.getKerning(previous, codepoint) : 0;
+
+        if ((stopped = full())) break;
+
+        if ((width > 0) && (previous != 0) && (line_width + kerning + advance > width)) {
+            if (previous == ' ') {
+                // The line ends before the spaces preceding this character
+
+                if (can_break) {
+                    end_line(break_end, break_width, break_spaces, false);
+                    start_line(start);
+                    kerning = 0;
+                }
+            }
+            else if (can_break) {
+                // The line ends at the last spaces, the current word going
+                // to the next line
+
+                end_line(break_end, break_width, break_spaces, false);
+                line.start  = next_start;
+                line.end    = start;
+                line_width -= next_offset;
+                spaces     -= next_spaces;
+                can_break   = false;
+            }
+            if ((line.end > line.start) && (previous != ' ') && (line_width + kerning + advance > width)) {
+                // A word wider than a line is broken before this character
+
+                end_line(start, line_width, spaces, false);
+                start_line(start);
+                kerning = 0;
+            }
+        }
+
+        if ((stopped = full())) break;
+
+        line_width += kerning + advance;
+        previous    = codepoint;
+        line.end    = pos;
+    }
+
+    if (stopped) {
+        end = line.start;
+        return lines.size();
+    }
+
+    // Last line, if not empty
+
+    if (line.end > line.start) {
+        if (previous == ' ')
+            end_line(line.end, break_width, break_spaces, true);
+        else
+            end_line(line.end, line_width, spaces, true);
+    }
+    else if (!lines.empty()) {
+        lines.back().last = true;
+    }
+
+    return lines.size();
+}
+
+int16_t TextLayout::getMaxWidth() const
+{
+    int16_t w = 0;
+    for (auto & line : lines) w = std::max(w, line.width);
+    return w;
+}
+
+void TextLayout::draw(Graphics & graphics, int16_t x, int16_t y, uint16_t color)
+{
+    if (text == nullptr) return;
+
+    int16_t baseline = y;
+
+    for (auto & line : lines) {
+        int32_t pen   = x;
+        int32_t extra = 0;  // Justification pixels to distribute
+        int32_t gaps  = 0;
+
+        switch (align) {
+            case Align::CENTER: pen += (width - line.width) / 2; break;
+            case Align::RIGHT:  pen +=  width - line.width;      break;
+            case Align::JUSTIFY:
+                if (!line.last && (line.spaces > 0) && (width > line.width)) {
+                    extra = width - line.width;
+                    gaps  = line.spaces;
+                }
+                break;
+            default: break;
+        }
+
+        uint32_t pos      = line.start;
+        uint32_t previous = 0;
+        int32_t  space    = 0;  // Index of the next space, for justification
+
+        while (pos < line.end) {
+            uint32_t codepoint = nextCodepoint(text, line.end, pos);
+            if (codepoint == 0) break;
+
+            if (codepoint == ' ') {
+                int16_t advance = font.getAdvance(' ');
+                if (advance < 0) continue;
+                pen += advance;
+                if (gaps) {
+                    // Spread as evenly as possible: the total added after
+                    // space i is extra * (i + 1) / gaps
+
+                    pen += (extra * (space + 1)) / gaps - (extra * space) / gaps;
+                    space++;
+                }
+                previous = 0;
+                continue;
+            }
+
+            FontGlyph glyph;
+            if (!font.getGlyph(codepoint, glyph)) continue;
+
+            if (previous) pen += font.getKerning(previous, codepoint);
+            graphics.drawGlyph(pen, baseline, glyph, color);
+            pen     += glyph.x_advance;
+            previous = codepoint;
+        }
+
+        baseline += line_height;
+    }
+}
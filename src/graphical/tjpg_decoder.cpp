@@ -9,6 +9,7 @@ https://github.com/Bodmer/TJpg_Decoder
 
 #include "tjpg_decoder.hpp"
 
+#include <cstdlib>
 #include <cstring>
 
 // Create a class instance to be used by the sketch (defined as extern in header)
@@ -102,6 +103,53 @@ uint16_t TJpg_Decoder::jd_input(JDEC *jdec, uint8_t *buf, uint16_t len)
         thisPtr->array_index += len;
     }
 
+    // Handle a file or stream input, read by blocks in the read-ahead buffer
+    else
+    {
+        bool file = thisPtr->jpg_source == TJPG_SD_FILE;
+        uint16_t count = 0;
+
+        while (count < len)
+        {
+            if (thisPtr->file_index >= thisPtr->file_count)
+            {
+                // Large skips (null buf) are seeked over in a file
+                uint16_t remaining = len - count;
+                if (file && !buf && (remaining >= TJPGD_FILE_BUFFER_SIZE))
+                {
+                    if (fseek(thisPtr->jpg_file, remaining, SEEK_CUR) != 0)
+                        break;
+                    count = len;
+                    break;
+                }
+
+                thisPtr->file_index = 0;
+                thisPtr->file_count = 0;
+                int32_t size;
+                if (file)
+                    size = fread(thisPtr->file_buffer, 1, TJPGD_FILE_BUFFER_SIZE, thisPtr->jpg_file);
+                else
+                    size = thisPtr->jpg_reader(thisPtr->jpg_context, thisPtr->file_buffer, TJPGD_FILE_BUFFER_SIZE);
+                if (size <= 0)
+                    break;
+                thisPtr->file_count = size;
+            }
+
+            uint16_t n = thisPtr->file_count - thisPtr->file_index;
+            if (n > len - count)
+                n = len - count;
+
+            // If buf is valid then copy n bytes to buffer
+            if (buf)
+                memcpy(buf + count, thisPtr->file_buffer + thisPtr->file_index, n);
+
+            thisPtr->file_index += n;
+            count += n;
+        }
+
+        len = count;
+    }
+
     return len;
 }
 
@@ -187,3 +235,143 @@ JRESULT TJpg_Decoder::getJpgSize(uint16_t *w, uint16_t *h, const uint8_t jpeg_da
 
     return jresult;
 }
+
+/***************************************************************************************
+** Function name:           openJpgInput
+** Description:             Setup the file or stream input and its read-ahead buffer
+***************************************************************************************/
+static bool openJpgInput(TJpg_Decoder *decoder, uint8_t source)
+{
+    decoder->file_buffer = (uint8_t *)malloc(TJPGD_FILE_BUFFER_SIZE);
+    if (!decoder->file_buffer)
+        return false;
+
+    decoder->jpg_source = source;
+    decoder->file_index = 0;
+    decoder->file_count = 0;
+
+    return true;
+}
+
+/***************************************************************************************
+** Function name:           closeJpgInput
+** Description:             Release the read-ahead buffer (the file or stream stays opened)
+***************************************************************************************/
+static void closeJpgInput(TJpg_Decoder *decoder)
+{
+    free(decoder->file_buffer);
+    decoder->file_buffer = nullptr;
+    decoder->jpg_file = nullptr;
+    decoder->jpg_reader = nullptr;
+    decoder->jpg_context = nullptr;
+    decoder->jpg_source = TJPG_ARRAY;
+}
+
+/***************************************************************************************
+** Function name:           decodeJpgInput
+** Description:             Draw, or get the size of, the jpg of an opened input
+***************************************************************************************/
+static JRESULT decodeJpgInput(TJpg_Decoder *decoder, uint16_t *w, uint16_t *h, bool dither, bool invert)
+{
+    JDEC jdec;
+    JRESULT jresult = JDR_OK;
+
+    jdec.swap = decoder->_swap;
+
+    // Analyse input data
+    jresult = jd_prepare(&jdec, TJpg_Decoder::jd_input, decoder->workspace, TJPGD_WORKSPACE_SIZE, 0);
+
+    if (jresult == JDR_OK)
+    {
+        // Extract image and render, or only return its size
+        if (w == nullptr)
+        {
+            jresult = jd_decomp(&jdec, TJpg_Decoder::jd_output, decoder->jpgScale, dither, invert);
+        }
+        else
+        {
+            *w = jdec.width;
+            *h = jdec.height;
+        }
+    }
+
+    closeJpgInput(decoder);
+
+    return jresult;
+}
+
+/***************************************************************************************
+** Function name:           drawJpg
+** Description:             Draw a jpg read from an opened file, a block at a time
+***************************************************************************************/
+JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, FILE *file, bool dither, bool invert)
+{
+    if (!openJpgInput(this, TJPG_SD_FILE))
+        return JDR_MEM1;
+
+    jpg_file = file;
+
+    jpeg_x = x;
+    jpeg_y = y;
+
+    return decodeJpgInput(this, nullptr, nullptr, dither, invert);
+}
+
+/***************************************************************************************
+** Function name:           getJpgSize
+** Description:             Get width and height of a jpg file, back at its start after
+***************************************************************************************/
+JRESULT TJpg_Decoder::getJpgSize(uint16_t *w, uint16_t *h, FILE *file)
+{
+    *w = 0;
+    *h = 0;
+
+    long start = ftell(file);
+
+    if (!openJpgInput(this, TJPG_SD_FILE))
+        return JDR_MEM1;
+
+    jpg_file = file;
+
+    JRESULT jresult = decodeJpgInput(this, w, h, false, false);
+
+    fseek(file, start, SEEK_SET);
+
+    return jresult;
+}
+
+/***************************************************************************************
+** Function name:           drawJpg
+** Description:             Draw a jpg read from a stream as it is decoded
+***************************************************************************************/
+JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, JpgReader reader, void *context, bool dither, bool invert)
+{
+    if (!openJpgInput(this, TJPG_STREAM))
+        return JDR_MEM1;
+
+    jpg_reader = reader;
+    jpg_context = context;
+
+    jpeg_x = x;
+    jpeg_y = y;
+
+    return decodeJpgInput(this, nullptr, nullptr, dither, invert);
+}
+
+/***************************************************************************************
+** Function name:           getJpgSize
+** Description:             Get width and height of a jpg stream (the stream is consumed)
+***************************************************************************************/
+JRESULT TJpg_Decoder::getJpgSize(uint16_t *w, uint16_t *h, JpgReader reader, void *context)
+{
+    *w = 0;
+    *h = 0;
+
+    if (!openJpgInput(this, TJPG_STREAM))
+        return JDR_MEM1;
+
+    jpg_reader = reader;
+    jpg_context = context;
+
+    return decodeJpgInput(this, w, h, false, false);
+}
@@ -277,3 +277,74 @@ NetworkClient::downloadFile(const char * url, int32_t * defaultLen)
 
   return buffer;
 }
+
+bool
+NetworkClient::openStream(const char * url, int32_t * length)
+{
+  if (!connected) return false;
+
+  closeStream();
+
+  ESP_LOGI(TAG, "Streaming file from URL: %s", url);
+
+  esp_http_client_config_t config;
+
+  memset(&config, 0, sizeof(config));
+
+  config.url = url;
+
+  if ((stream = esp_http_client_init(&config)) == nullptr) return false;
+
+  if (esp_http_client_open(stream, 0) != ESP_OK) {
+    ESP_LOGE(TAG, "Unable to connect to %s", url);
+    closeStream();
+    return false;
+  }
+
+  int32_t content_length = esp_http_client_fetch_headers(stream);
+  int     status         = esp_http_client_get_status_code(stream);
+
+  if ((content_length < 0) || (status != 200)) {
+    ESP_LOGE(TAG, "Unable to get %s, status = %d", url, status);
+    closeStream();
+    return false;
+  }
+
+  if (length != nullptr) {
+    *length = esp_http_client_is_chunked_response(stream) ? -1 : content_length;
+  }
+
+  return true;
+}
+
+int32_t
+NetworkClient::readStream(uint8_t * buf, int32_t len)
+{
+  if (stream == nullptr) return -1;
+
+  // Each read returns what has been received so far
+
+  int32_t count = 0;
+
+  while (count < len) {
+    int size = esp_http_client_read(stream, (char *) buf + count, len - count);
+    if (size < 0) {
+      ESP_LOGE(TAG, "Stream read error.");
+      return -1;
+    }
+    if (size == 0) break;
+    count += size;
+  }
+
+  return count;
+}
+
+void
+NetworkClient::closeStream()
+{
+  if (stream != nullptr) {
+    esp_http_client_close(stream);
+    esp_http_client_cleanup(stream);
+    stream = nullptr;
+  }
+}
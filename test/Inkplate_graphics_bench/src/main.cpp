@@ -0,0 +1,507 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "logging.hpp"
+#include "esp_timer.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "inkplate.hpp"
+#include "FreeSerif12pt7b.h"
+
+// Graphics primitives benchmarks. Results are sent to the usb port
+// through the log. The drawing of the last benchmark is shown on the
+// screen.
+
+Inkplate display(DisplayMode::INKPLATE_1BIT);
+
+static const char * TAG = "Bench";
+
+static const int MAX_ITER = 32;
+
+// Mandelbrot set iteration count for a screen position, in fixed point
+// arithmetic. The same computation is used by all the plot variants such
+// that the difference between their timings is the cost of writing the
+// pixels.
+
+static inline int mandelbrot(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  int32_t cr = ((int32_t) x * (3 << 12)) / w - (2 << 12) - (1 << 11);
+  int32_t ci = ((int32_t) y * (2 << 12)) / h - (1 << 12);
+  int32_t zr = 0, zi = 0;
+  int     i;
+
+  for (i = 0; i < MAX_ITER; i++) {
+    int32_t zr2 = (zr * zr) >> 12;
+    int32_t zi2 = (zi * zi) >> 12;
+    if ((zr2 + zi2) > (4 << 12)) break;
+    zi = ((zr * zi) >> 11) + ci;
+    zr = zr2 - zi2 + cr;
+  }
+  return i;
+}
+
+static inline uint16_t mandelbrot_color(int iter)
+{
+  if (display.getDisplayMode() == DisplayMode::INKPLATE_1BIT) return (iter == MAX_ITER) ? 1 : (iter & 1);
+  return (iter == MAX_ITER) ? 0 : (7 - (iter % 7));
+}
+
+static volatile uint32_t sink_hole;
+
+static int64_t plot_compute_only()
+{
+  int16_t  w = display.width(), h = display.height();
+  uint32_t sum = 0;
+  int64_t  start = esp_timer_get_time();
+
+  for (int16_t y = 0; y < h; y++) {
+    for (int16_t x = 0; x < w; x++) {
+      sum += mandelbrot_color(mandelbrot(x, y, w, h));
+    }
+  }
+  sink_hole = sum;
+  return esp_timer_get_time() - start;
+}
+
+static int64_t plot_draw_pixel()
+{
+  int16_t w = display.width(), h = display.height();
+  int64_t start = esp_timer_get_time();
+
+  for (int16_t y = 0; y < h; y++) {
+    for (int16_t x = 0; x < w; x++) {
+      display.drawPixel(x, y, mandelbrot_color(mandelbrot(x, y, w, h)));
+    }
+  }
+  return esp_timer_get_time() - start;
+}
+
+static int64_t plot_pixel_sink()
+{
+  int16_t w = display.width(), h = display.height();
+  int64_t start = esp_timer_get_time();
+
+  display.withPixelSink([&](auto & sink) {
+    for (int16_t y = 0; y < h; y++) {
+      for (int16_t x = 0; x < w; x++) {
+        sink.writePixel(x, y, mandelbrot_color(mandelbrot(x, y, w, h)));
+      }
+    }
+  });
+  return esp_timer_get_time() - start;
+}
+
+static void bench_pixels()
+{
+  int32_t count = (int32_t) display.width() * display.height();
+
+  int64_t base = plot_compute_only();
+  int64_t virt = plot_draw_pixel();
+  int64_t sink = plot_pixel_sink();
+
+  ESP_LOGI(TAG, "Mandelbrot, %s, rotation %d, %d pixels:",
+    display.getDisplayMode() == DisplayMode::INKPLATE_1BIT ? "1 bit" : "3 bits",
+    display.getRotation(), count);
+  ESP_LOGI(TAG, "  compute only: %8lld us", base);
+  ESP_LOGI(TAG, "  drawPixel:    %8lld us, %5lld ns per pixel", virt, ((virt - base) * 1000) / count);
+  ESP_LOGI(TAG, "  pixel sink:   %8lld us, %5lld ns per pixel", sink, ((sink - base) * 1000) / count);
+}
+
+// Gauge style widgets: a thick dial ring, a value arc, tick marks and a hub,
+// in a grid covering the screen.
+
+static void draw_gauge(int xc, int yc, int r, int value)
+{
+  display.drawThickElipse(r, r, xc, yc, 3, 0);
+  display.drawElipseArc(r - 6, r - 6, xc, yc, 135, 135 + (270 * value) / 100, 10, 2);
+  for (int a = 135; a <= 405; a += 27) {
+    display.drawElipseArc(r - 18, r - 18, xc, yc, a - 1, a + 1, 6, 0);
+  }
+  display.fillElipse(r / 8, r / 8, xc, yc, 0);
+  display.drawElipse(r / 4, r / 4, xc, yc, 0);
+}
+
+static void bench_gauges()
+{
+  const int r = 60;
+  int16_t w = display.width(), h = display.height();
+  int count = 0;
+
+  display.clearDisplay();
+
+  int64_t start = esp_timer_get_time();
+
+  for (int y = r; y + r < h; y += 2 * r + 8) {
+    for (int x = r; x + r < w; x += 2 * r + 8) {
+      draw_gauge(x, y, r, (count * 37) % 101);
+      count++;
+    }
+  }
+
+  int64_t elapsed = esp_timer_get_time() - start;
+
+  ESP_LOGI(TAG, "Gauges, %s, rotation %d: %d gauges in %lld us, %lld us per gauge",
+    display.getDisplayMode() == DisplayMode::INKPLATE_1BIT ? "1 bit" : "3 bits",
+    display.getRotation(), count, elapsed, elapsed / count);
+}
+
+// Graph plotting: a 2000 points series drawn as individual thick lines
+// and as a single thick polyline.
+
+static const int GRAPH_POINTS = 2000;
+
+static int graph_x[GRAPH_POINTS];
+static int graph_y[GRAPH_POINTS];
+
+static void bench_graph()
+{
+  int16_t w = display.width(), h = display.height();
+
+  for (int i = 0; i < GRAPH_POINTS; i++) {
+    graph_x[i] = ((int32_t) i * (w - 1)) / (GRAPH_POINTS - 1);
+    graph_y[i] = h / 2 + (((i * 7919) % 61) - 30) * h / 160 + (((i / 50) & 1) ? h / 8 : -h / 8);
+  }
+
+  display.clearDisplay();
+
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < GRAPH_POINTS - 1; i++) {
+    display.drawThickLine(graph_x[i], graph_y[i], graph_x[i + 1], graph_y[i + 1], 1, 3);
+  }
+  int64_t lines = esp_timer_get_time() - start;
+
+  display.clearDisplay();
+
+  start = esp_timer_get_time();
+  display.drawThickPolyline(graph_x, graph_y, GRAPH_POINTS, 1, 3);
+  int64_t polyline = esp_timer_get_time() - start;
+
+  ESP_LOGI(TAG, "Graph, %d segments: drawThickLine: %lld us, drawThickPolyline: %lld us",
+    GRAPH_POINTS - 1, lines, polyline);
+}
+
+// Icon blitting: a 64x64 1-bit icon copied over the whole screen, to
+// compare the rotations.
+
+static uint8_t icon[8 * 64];
+
+static void bench_blit()
+{
+  int16_t w = display.width(), h = display.height();
+  int count = 0;
+
+  for (int i = 0; i < (int) sizeof(icon); i++) icon[i] = (i * 7919) >> 3;
+
+  display.clearDisplay();
+
+  int64_t start = esp_timer_get_time();
+  for (int y = 0; y + 64 <= h; y += 64) {
+    for (int x = 0; x + 64 <= w; x += 64) {
+      display.blit(x, y, icon, 64, 64, RasterOp::XOR);
+      count++;
+    }
+  }
+  int64_t elapsed = esp_timer_get_time() - start;
+
+  ESP_LOGI(TAG, "Blit, rotation %d: %d icons in %lld us, %lld us per icon",
+    display.getRotation(), count, elapsed, elapsed / count);
+}
+
+// Text page: the same lines of text drawn with the glyph cache disabled,
+// then enabled.
+
+static const char * PAGE_LINE = "The quick brown fox jumps over the lazy dog. 0123456789";
+
+static int64_t draw_page()
+{
+  int16_t h = display.height();
+
+  display.clearDisplay();
+  display.setFont(&FreeSerif12pt7b);
+  display.setTextColor(BLACK);
+
+  int64_t start = esp_timer_get_time();
+  for (int16_t y = 24; y < h; y += 24) {
+    display.setCursor(5, y);
+    display.print(PAGE_LINE);
+  }
+  return esp_timer_get_time() - start;
+}
+
+static void bench_text()
+{
+  GlyphCache & cache    = display.getGlyphCache();
+  uint32_t     capacity = cache.getCapacity();
+
+  cache.setCapacity(0);
+  int64_t uncached = draw_page();
+
+  cache.setCapacity(capacity);
+  cache.resetCounters();
+  int64_t first  = draw_page();
+  int64_t second = draw_page();
+
+  ESP_LOGI(TAG, "Text page, rotation %d: no cache: %lld us, cache: %lld us, then %lld us, hit rate %d%%",
+    display.getRotation(), uncached, first, second, (int) (cache.getHitRate() * 100));
+}
+
+// Large clock numerals: scaled glyphs drawn as runs, compared to the
+// Adafruit_GFX rendering (a rectangle per glyph pixel), then with a
+// fractional scale.
+
+static const char * CLOCK = "12:34";
+
+static int64_t draw_clock(bool runs)
+{
+  display.clearDisplay();
+  display.setFont(&FreeSerif12pt7b);
+  display.setTextColor(BLACK);
+  display.setTextSize(8);
+
+  int64_t start = esp_timer_get_time();
+  display.setCursor(10, 300);
+  if (runs) {
+    display.print(CLOCK);
+  }
+  else {
+    for (const char * c = CLOCK; *c; c++) {
+      display.Adafruit_GFX::drawChar(display.getCursorX(), 300, *c, BLACK, BLACK, 8, 8);
+      display.setCursor(display.getCursorX() + FreeSerif12pt7b.glyph[*c - FreeSerif12pt7b.first].xAdvance * 8, 300);
+    }
+  }
+  return esp_timer_get_time() - start;
+}
+
+static void bench_clock()
+{
+  GlyphCache & cache    = display.getGlyphCache();
+  uint32_t     capacity = cache.getCapacity();
+
+  cache.setCapacity(0);
+
+  int64_t pixels = draw_clock(false);
+  int64_t runs   = draw_clock(true);
+
+  display.clearDisplay();
+  display.setTextScale(7.5);
+  display.setCursor(10, 300);
+  int64_t start = esp_timer_get_time();
+  display.print(CLOCK);
+  int64_t fractional = esp_timer_get_time() - start;
+
+  display.setTextSize(1);
+  cache.setCapacity(capacity);
+
+  ESP_LOGI(TAG, "Clock x8, rotation %d: pixel rectangles: %lld us, runs: %lld us, x7.5: %lld us",
+    display.getRotation(), pixels, runs, fractional);
+}
+
+// Reference ellipses: the previous implementations, a pixel at a time, in
+// floating point for the outline. Used to check that the span based ones
+// draw the same pixels.
+
+static void reference_draw_elipse(int rx, int ry, int xc, int yc, int c)
+{
+  float dx, dy, d1, d2, x, y;
+  x = 0;
+  y = ry;
+
+  d1 = (ry * ry) - (rx * rx * ry) + (0.25 * rx * rx);
+  dx = 2 * ry * ry * x;
+  dy = 2 * rx * rx * y;
+
+  while (dx < dy) {
+    display.drawPixel( x + xc,  y + yc, c);
+    display.drawPixel(-x + xc,  y + yc, c);
+    display.drawPixel( x + xc, -y + yc, c);
+    display.drawPixel(-x + xc, -y + yc, c);
+
+    x++;
+    dx = dx + (2 * ry * ry);
+    if (d1 < 0) {
+      d1 = d1 + dx + (ry * ry);
+    }
+    else {
+      y--;
+      dy = dy - (2 * rx * rx);
+      d1 = d1 + dx - dy + (ry * ry);
+    }
+  }
+
+  d2 = ((ry * ry) * ((x + 0.5) * (x + 0.5))) + ((rx * rx) * ((y - 1) * (y - 1))) - (rx * rx * ry * ry);
+  while (y >= 0) {
+    display.drawPixel( x + xc,  y + yc, c);
+    display.drawPixel(-x + xc,  y + yc, c);
+    display.drawPixel( x + xc, -y + yc, c);
+    display.drawPixel(-x + xc, -y + yc, c);
+
+    y--;
+    dy = dy - (2 * rx * rx);
+    if (d2 > 0) {
+      d2 = d2 + (rx * rx) - dy;
+    }
+    else {
+      x++;
+      dx = dx + (2 * ry * ry);
+      d2 = d2 + dx - dy + (rx * rx);
+    }
+  }
+}
+
+static void reference_fill_elipse(int rx, int ry, int xc, int yc, int c)
+{
+  int hh   = ry * ry;
+  int ww   = rx * rx;
+  int hhww = hh * ww;
+  int x0   = rx;
+  int dx   = 0;
+
+  for (int x = -rx; x <= rx; x++) display.drawPixel(xc + x, yc, c);
+
+  for (int y = 1; y <= ry; y++) {
+    int x1 = x0 - (dx - 1);
+    for (; x1 > 0; x1--) {
+      if (x1 * x1 * hh + y * y * ww <= hhww) break;
+    }
+    dx = x0 - x1;
+    x0 = x1;
+
+    for (int x = -x0; x <= x0; x++) {
+      display.drawPixel(xc + x, yc - y, c);
+      display.drawPixel(xc + x, yc + y, c);
+    }
+  }
+}
+
+static std::vector<uint8_t> capture(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  std::vector<uint8_t> pixels;
+
+  pixels.reserve((int32_t) w * h);
+  display.withPixelSink([&](auto & sink) {
+    for (int16_t j = y; j < y + h; j++) {
+      for (int16_t i = x; i < x + w; i++) pixels.push_back(sink.getPixel(i, j));
+    }
+  });
+  return pixels;
+}
+
+// Each shape is drawn by the reference and by the library, centered on the
+// screen, and the pixels of its bounding box compared. Thick rings and pie
+// slices as thick as their smaller radius must be the filled ellipse.
+
+template <typename F, typename G>
+static bool same_elipse(int rx, int ry, F reference, G drawn)
+{
+  int16_t xc = display.width() / 2, yc = display.height() / 2;
+
+  display.clearDisplay();
+  reference(rx, ry, xc, yc);
+  std::vector<uint8_t> expected = capture(xc - rx - 1, yc - ry - 1, 2 * rx + 3, 2 * ry + 3);
+
+  display.clearDisplay();
+  drawn(rx, ry, xc, yc);
+  return capture(xc - rx - 1, yc - ry - 1, 2 * rx + 3, 2 * ry + 3) == expected;
+}
+
+static int check_elipses()
+{
+  int count = 0, differ = 0;
+
+  for (int rx = 0; rx <= 200; rx += 5) {
+    for (int ry = 0; ry <= 200; ry += 7) {
+      int r = std::max(std::min(rx, ry), 1);
+
+      differ += !same_elipse(rx, ry,
+        [](int rx, int ry, int xc, int yc) { reference_draw_elipse(rx, ry, xc, yc, 1); },
+        [](int rx, int ry, int xc, int yc) { display.drawElipse(rx, ry, xc, yc, 1); });
+      differ += !same_elipse(rx, ry,
+        [](int rx, int ry, int xc, int yc) { reference_fill_elipse(rx, ry, xc, yc, 1); },
+        [](int rx, int ry, int xc, int yc) { display.fillElipse(rx, ry, xc, yc, 1); });
+      differ += !same_elipse(rx, ry,
+        [](int rx, int ry, int xc, int yc) { reference_fill_elipse(rx, ry, xc, yc, 1); },
+        [r](int rx, int ry, int xc, int yc) { display.drawThickElipse(rx, ry, xc, yc, r, 1); });
+      differ += !same_elipse(rx, ry,
+        [](int rx, int ry, int xc, int yc) { reference_fill_elipse(rx, ry, xc, yc, 1); },
+        [r](int rx, int ry, int xc, int yc) { display.drawElipseArc(rx, ry, xc, yc, 0, 360, r, 1); });
+      count += 4;
+    }
+  }
+
+  ESP_LOGI(TAG, "Ellipses: %d of %d differ from the reference", differ, count);
+
+  return differ;
+}
+
+void delay(int sec = 5) { vTaskDelay((sec * 1000) / portTICK_PERIOD_MS); }
+
+void mainTask(void * params)
+{
+  // Show a downcount of 10 seconds at the usb port
+  for (int i = 10; i > 0; i--) {
+    std::cout << "\r" << i << "..." << std::flush;
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+  }
+  std::cout << std::endl << std::flush;
+
+  ESP_LOGI(TAG, "Initialization.");
+
+  display.begin();
+
+  for (auto mode : { DisplayMode::INKPLATE_1BIT, DisplayMode::INKPLATE_3BIT }) {
+    display.selectDisplayMode(mode);
+    for (uint8_t rotation = 0; rotation < 4; rotation++) {
+      display.setRotation(rotation);
+      display.clearDisplay();
+      bench_pixels();
+    }
+  }
+
+  display.selectDisplayMode(DisplayMode::INKPLATE_1BIT);
+  display.setRotation(0);
+  check_elipses();
+  bench_graph();
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    display.setRotation(rotation);
+    bench_blit();
+  }
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    display.setRotation(rotation);
+    bench_text();
+    bench_clock();
+  }
+
+  display.selectDisplayMode(DisplayMode::INKPLATE_3BIT);
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    display.setRotation(rotation);
+    bench_gauges();
+  }
+
+  display.setRotation(0);
+  display.display();
+
+  for (;;) {
+    ESP_LOGI(TAG, "Completed...");
+    delay(15);
+  }
+}
+
+#define STACK_SIZE 10000
+
+extern "C" {
+
+  void app_main()
+  {
+    TaskHandle_t xHandle = NULL;
+
+    xTaskCreate(mainTask, "mainTask", STACK_SIZE, (void *) 1, tskIDLE_PRIORITY, &xHandle);
+    configASSERT(xHandle);
+  }
+
+} // extern "C"
@@ -0,0 +1,232 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Font file converter: generates a compressed font file (see
+// include/graphical/font_file.hpp) from a TrueType or OpenType font, to be
+// put on the SD card and read with the FontFile class.
+//
+// To build it (the FreeType and zlib libraries are required), on a single line:
+//
+//   g++ -std=c++17 -O2 -I../../include/graphical -o font_file_convert font_file_convert.cpp
+//     `pkg-config --cflags --libs freetype2` -lz
+//
+// Usage:
+//
+//   font_file_convert [-n] [-k] [-p page_size] fontfile size bpp output [range...]
+//
+// size is in points (at 141 dpi, as for the Adafruit fontconvert utility),
+// bpp is 1, 2 or 4 and each range is a pair of code points, like 0x20-0x7E
+// (the default) or 0x370-0x3FF. Code points absent from the font are
+// skipped. Glyph bitmaps are grouped in pages of about page_size bytes
+// (default: 4096) that are zlib compressed, unless -n is given. With -k, the
+// kerning of all pairs of glyphs is retrieved from the font kern table (the
+// time required grows with the square of the glyph count).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <zlib.h>
+
+#include "font_file.hpp"
+
+static constexpr int DPI = 141;
+
+int main(int argc, char * argv[])
+{
+  bool     compress  = true;
+  bool     kerning   = false;
+  uint32_t page_size = 4096;
+  int      opt;
+
+  while ((opt = getopt(argc, argv, "nkp:")) != -1) {
+    if (opt == 'n') compress = false;
+    else if (opt == 'k') kerning = true;
+    else if (opt == 'p') page_size = strtoul(optarg, nullptr, 0);
+    else {
+      fprintf(stderr, "Usage: %s [-n] [-k] [-p page_size] fontfile size bpp output [range...]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (argc - optind < 4) {
+    fprintf(stderr, "Usage: %s [-n] [-k] [-p page_size] fontfile size bpp output [range...]\n", argv[0]);
+    return 1;
+  }
+
+  const char * font_name = argv[optind];
+  int          size      = atoi(argv[optind + 1]);
+  int          bpp       = atoi(argv[optind + 2]);
+  const char * output    = argv[optind + 3];
+
+  if ((size <= 0) || ((bpp != 1) && (bpp != 2) && (bpp != 4)) || (page_size == 0) || (page_size > 0x10000)) {
+    fprintf(stderr, "Invalid size, bpp or page size.\n");
+    return 1;
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> requested;
+  for (int i = optind + 4; i < argc; i++) {
+    char *   end;
+    uint32_t first = strtoul(argv[i], &end, 0);
+    uint32_t last  = (*end == '-') ? strtoul(end + 1, nullptr, 0) : first;
+    if (last < first) {
+      fprintf(stderr, "Invalid range %s.\n", argv[i]);
+      return 1;
+    }
+    requested.push_back({ first, last });
+  }
+  if (requested.empty()) requested.push_back({ 0x20, 0x7E });
+
+  FT_Library library;
+  FT_Face    face;
+
+  if (FT_Init_FreeType(&library) || FT_New_Face(library, font_name, 0, &face) ||
+      FT_Set_Char_Size(face, size << 6, 0, DPI, 0)) {
+    fprintf(stderr, "Unable to load font file %s.\n", font_name);
+    return 1;
+  }
+
+  // Glyphs, in code point order. Ranges are split where code points are
+  // missing from the font.
+
+  std::vector<FontFile::Range> ranges;
+  std::vector<FontFile::Glyph> glyphs;
+  std::vector<FontFile::Page>  pages;
+  std::vector<uint8_t>         page;
+  std::vector<uint8_t>         data;
+  uint32_t                     page_first = 0; // Index of the first glyph of the current page
+  int                          max        = (1 << bpp) - 1;
+
+  auto flush_page = [&]() {
+    if (page.empty()) return;
+
+    FontFile::Page p = { page_first, (uint32_t) data.size(), 0, (uint32_t) page.size() };
+
+    if (compress) {
+      uLongf packed_size = compressBound(page.size());
+      std::vector<uint8_t> packed(packed_size);
+      compress2(packed.data(), &packed_size, page.data(), page.size(), Z_BEST_COMPRESSION);
+      data.insert(data.end(), packed.begin(), packed.begin() + packed_size);
+      p.size = packed_size;
+    }
+    else {
+      data.insert(data.end(), page.begin(), page.end());
+      p.size = page.size();
+    }
+
+    pages.push_back(p);
+    page.clear();
+    page_first = glyphs.size();
+  };
+
+  for (auto & r : requested) {
+    for (uint32_t c = r.first; c <= r.second; c++) {
+      if ((FT_Get_Char_Index(face, c) == 0) ||
+          FT_Load_Char(face, c, (bpp == 1) ? (FT_LOAD_TARGET_MONO | FT_LOAD_RENDER) : FT_LOAD_RENDER)) continue;
+
+      FT_GlyphSlot slot = face->glyph;
+      FT_Bitmap &  bm   = slot->bitmap;
+
+      if (ranges.empty() || (ranges.back().first + ranges.back().count != c)) ranges.push_back({ c, 0 });
+      ranges.back().count++;
+
+      uint32_t row_bytes = (bm.width * bpp + 7) >> 3;
+      if (page.size() + row_bytes * bm.rows > page_size) flush_page();
+
+      FontFile::Glyph g = { (uint16_t) page.size(), (uint8_t) bm.width, (uint8_t) bm.rows,
+                            (uint8_t) (slot->advance.x >> 6), (int8_t) slot->bitmap_left,
+                            (int8_t) (1 - slot->bitmap_top), 0 };
+      glyphs.push_back(g);
+
+      for (unsigned int j = 0; j < bm.rows; j++) {
+        const uint8_t * src = &bm.buffer[j * bm.pitch];
+        if (bpp == 1) {
+          page.insert(page.end(), src, src + row_bytes);
+          continue;
+        }
+        uint8_t byte = 0;
+        int     bit  = 0;
+        for (unsigned int i = 0; i < bm.width; i++) {
+          byte |= ((src[i] * max + 127) / 255) << (8 - bpp - bit);
+          bit  += bpp;
+          if (bit == 8) {
+            page.push_back(byte);
+            byte = 0;
+            bit  = 0;
+          }
+        }
+        if (bit) page.push_back(byte);
+      }
+    }
+  }
+  flush_page();
+
+  // Kerning pairs, in code point order
+
+  std::vector<FontFile::Kerning> kernings;
+
+  if (kerning && FT_HAS_KERNING(face)) {
+    std::vector<uint32_t> codepoints;
+    for (auto & r : ranges) {
+      for (uint32_t c = r.first; c < r.first + r.count; c++) codepoints.push_back(c);
+    }
+    for (uint32_t left : codepoints) {
+      FT_UInt left_index = FT_Get_Char_Index(face, left);
+      for (uint32_t right : codepoints) {
+        FT_Vector delta;
+        if (FT_Get_Kerning(face, left_index, FT_Get_Char_Index(face, right), FT_KERNING_DEFAULT, &delta)) continue;
+        int value = (delta.x + 32) >> 6;
+        if (value != 0) kernings.push_back({ left, right, (int8_t) value, { 0, 0, 0 } });
+      }
+    }
+  }
+
+  FontFile::Header header;
+
+  memcpy(header.magic, FontFile::MAGIC, 4);
+  header.version     = FontFile::VERSION;
+  header.bpp         = bpp;
+  header.y_advance   = face->size->metrics.height >> 6;
+  header.compression = (uint8_t) (compress ? FontFile::Compression::ZLIB : FontFile::Compression::NONE);
+  header.range_count = ranges.size();
+  header.page_count  = pages.size();
+  header.glyph_count = glyphs.size();
+  header.kerning_count = kernings.size();
+
+  uint32_t data_offset = sizeof(FontFile::Header) +
+                         ranges.size() * sizeof(FontFile::Range) +
+                         glyphs.size() * sizeof(FontFile::Glyph) +
+                         pages.size()  * sizeof(FontFile::Page) +
+                         kernings.size() * sizeof(FontFile::Kerning);
+
+  for (auto & p : pages) p.file_offset += data_offset;
+
+  FILE * f = fopen(output, "wb");
+  if (f == nullptr) {
+    fprintf(stderr, "Unable to create %s.\n", output);
+    return 1;
+  }
+
+  fwrite(&header,       sizeof(FontFile::Header), 1,             f);
+  fwrite(ranges.data(), sizeof(FontFile::Range),  ranges.size(), f);
+  fwrite(glyphs.data(), sizeof(FontFile::Glyph),  glyphs.size(), f);
+  fwrite(pages.data(),  sizeof(FontFile::Page),   pages.size(),  f);
+  fwrite(kernings.data(), sizeof(FontFile::Kerning), kernings.size(), f);
+  fwrite(data.data(),   1,                        data.size(),   f);
+  fclose(f);
+
+  printf("%s: %u glyphs in %u ranges, %u pages, %u kerning pairs, %u bytes.\n", output,
+         (unsigned int) glyphs.size(), (unsigned int) ranges.size(), (unsigned int) pages.size(),
+         (unsigned int) kernings.size(), data_offset + (unsigned int) data.size());
+
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+
+  return 0;
+}
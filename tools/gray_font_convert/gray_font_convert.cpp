@@ -0,0 +1,168 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Anti-aliased font converter: generates a GrayFont header file (see
+// include/graphical/gray_font.hpp) from a TrueType or OpenType font, in the
+// same way the Adafruit fontconvert utility does for GFXfont. The glyph
+// metrics are identical, each pixel being given its coverage on 2 or 4 bits
+// instead of a single one.
+//
+// To build it (the FreeType library is required):
+//
+//   g++ -O2 -o gray_font_convert gray_font_convert.cpp `pkg-config --cflags --libs freetype2`
+//
+// Usage:
+//
+//   gray_font_convert fontfile size bpp [first] [last] > FontName.h
+//
+// size is in points (at 141 dpi, as for fontconvert), bpp is 2 or 4, and
+// first and last are the character codes range (default: 0x20 to 0x7E).
+// The generated font is named from the font file name, the size, the
+// character range and the number of bits per pixel, e.g. FreeSans12pt7bGray4.
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+static constexpr int DPI = 141;
+
+struct Glyph {
+  uint32_t offset;
+  int      width, height, x_advance, x_offset, y_offset;
+};
+
+int main(int argc, char * argv[])
+{
+  if (argc < 4) {
+    fprintf(stderr, "Usage: %s fontfile size bpp [first] [last]\n", argv[0]);
+    return 1;
+  }
+
+  int size  = atoi(argv[2]);
+  int bpp   = atoi(argv[3]);
+  int first = (argc > 4) ? strtol(argv[4], nullptr, 0) : 0x20;
+  int last  = (argc > 5) ? strtol(argv[5], nullptr, 0) : 0x7E;
+
+  if ((size <= 0) || ((bpp != 2) && (bpp != 4)) || (first < 0) || (last > 255) || (first > last)) {
+    fprintf(stderr, "Invalid size, bpp or character range.\n");
+    return 1;
+  }
+
+  // Font name, as for fontconvert: the file name without path and extension,
+  // stripped of anything that is not a letter or a digit.
+
+  std::string name = argv[1];
+  size_t      pos  = name.find_last_of("/\\");
+  if (pos != std::string::npos) name = name.substr(pos + 1);
+  pos = name.find_last_of('.');
+  if (pos != std::string::npos) name = name.substr(0, pos);
+
+  std::string font_name;
+  for (char ch : name) if (isalnum((unsigned char) ch)) font_name += ch;
+  font_name += std::to_string(size) + "pt" + ((last > 127) ? "8b" : "7b") + "Gray" + std::to_string(bpp);
+
+  FT_Library library;
+  FT_Face    face;
+
+  if (FT_Init_FreeType(&library)) {
+    fprintf(stderr, "FreeType initialization error.\n");
+    return 1;
+  }
+  if (FT_New_Face(library, argv[1], 0, &face)) {
+    fprintf(stderr, "Unable to load font file %s.\n", argv[1]);
+    FT_Done_FreeType(library);
+    return 1;
+  }
+  if (FT_Set_Char_Size(face, size << 6, 0, DPI, 0)) {
+    fprintf(stderr, "Unable to set the font size.\n");
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return 1;
+  }
+
+  int                  max   = (1 << bpp) - 1;
+  std::vector<uint8_t> bitmap;
+  std::vector<Glyph>   glyphs;
+
+  for (int c = first; c <= last; c++) {
+    Glyph glyph = { (uint32_t) bitmap.size(), 0, 0, 0, 0, 0 };
+
+    if (FT_Load_Char(face, c, FT_LOAD_TARGET_NORMAL) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
+      fprintf(stderr, "Unable to render character 0x%02X, left empty.\n", c);
+      glyphs.push_back(glyph);
+      continue;
+    }
+
+    FT_GlyphSlot slot = face->glyph;
+    FT_Bitmap &  bm   = slot->bitmap;
+
+    glyph.width     = bm.width;
+    glyph.height    = bm.rows;
+    glyph.x_advance = slot->advance.x >> 6;
+    glyph.x_offset  = slot->bitmap_left;
+    glyph.y_offset  = 1 - slot->bitmap_top;
+
+    // 8 bits coverage brought to bpp bits, rows starting on a byte boundary
+
+    for (unsigned int j = 0; j < bm.rows; j++) {
+      const uint8_t * src  = &bm.buffer[j * bm.pitch];
+      uint8_t         byte = 0;
+      int             bit  = 0;
+
+      for (unsigned int i = 0; i < bm.width; i++) {
+        byte |= ((src[i] * max + 127) / 255) << (8 - bpp - bit);
+        bit  += bpp;
+        if (bit == 8) {
+          bitmap.push_back(byte);
+          byte = 0;
+          bit  = 0;
+        }
+      }
+      if (bit) bitmap.push_back(byte);
+    }
+
+    glyphs.push_back(glyph);
+  }
+
+  if (bitmap.size() > 0xFFFF) {
+    fprintf(stderr, "Bitmap too large (%u bytes) for the 16 bits glyph offsets.\n", (unsigned int) bitmap.size());
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return 1;
+  }
+
+  printf("const uint8_t %sBitmaps[] PROGMEM = {", font_name.c_str());
+  for (size_t i = 0; i < bitmap.size(); i++) {
+    printf("%s0x%02X%s", (i % 12) ? " " : "\n  ", bitmap[i], (i + 1 < bitmap.size()) ? "," : "");
+  }
+  printf(" };\n\n");
+
+  printf("const GFXglyph %sGlyphs[] PROGMEM = {\n", font_name.c_str());
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    const Glyph & g = glyphs[i];
+    int           c = first + i;
+    printf("  { %5u, %3d, %3d, %3d, %4d, %4d }%s // 0x%02X", g.offset, g.width, g.height, g.x_advance,
+           g.x_offset, g.y_offset, (i + 1 < glyphs.size()) ? ",  " : " };", c);
+    if ((c >= 0x20) && (c <= 0x7E)) printf(" '%c'", c);
+    printf("\n");
+  }
+
+  printf("\nconst GrayFont %s PROGMEM = {\n", font_name.c_str());
+  printf("  { (uint8_t  *)%sBitmaps,\n", font_name.c_str());
+  printf("    (GFXglyph *)%sGlyphs,\n", font_name.c_str());
+  printf("    0x%02X, 0x%02X, %ld },\n", first, last, face->size->metrics.height >> 6);
+  printf("  %d };\n\n", bpp);
+  printf("// Approx. %u bytes\n", (unsigned int) (bitmap.size() + glyphs.size() * 7 + 8));
+
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+
+  return 0;
+}
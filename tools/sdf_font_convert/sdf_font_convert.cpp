@@ -0,0 +1,163 @@
+// Copyright (c) 2021 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Signed distance field font converter: generates an SDFFont header file
+// (see include/graphical/sdf_font.hpp) from a TrueType or OpenType font. A
+// single such font is rendered at any size by the SDFFontSource class.
+//
+// To build it (the FreeType library, version 2.11 or later, is required):
+//
+//   g++ -O2 -o sdf_font_convert sdf_font_convert.cpp `pkg-config --cflags --libs freetype2`
+//
+// Usage:
+//
+//   sdf_font_convert fontfile size [spread] [first] [last] > FontName.h
+//
+// size is the em size, in pixels, the distance fields are computed at (24
+// to 48 is a good compromise between the quality of the large sizes and
+// the font footprint), spread is the distance range in pixels (default: 4)
+// and first and last are the character codes range (default: 0x20 to
+// 0x7E). The generated font is named from the font file name and the size,
+// e.g. FreeSansSDF32.
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+
+struct Glyph {
+  uint32_t offset;
+  int      width, height, x_advance, x_offset, y_offset;
+};
+
+int main(int argc, char * argv[])
+{
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s fontfile size [spread] [first] [last]\n", argv[0]);
+    return 1;
+  }
+
+  int size   = atoi(argv[2]);
+  int spread = (argc > 3) ? atoi(argv[3]) : 4;
+  int first  = (argc > 4) ? strtol(argv[4], nullptr, 0) : 0x20;
+  int last   = (argc > 5) ? strtol(argv[5], nullptr, 0) : 0x7E;
+
+  if ((size < 8) || (size > 127) || (spread < 2) || (spread > 32) ||
+      (first < 0) || (last > 0xFFFF) || (first > last)) {
+    fprintf(stderr, "Invalid size, spread or character range.\n");
+    return 1;
+  }
+
+  // Font name: the file name without path and extension, stripped of
+  // anything that is not a letter or a digit.
+
+  std::string name = argv[1];
+  size_t      pos  = name.find_last_of("/\\");
+  if (pos != std::string::npos) name = name.substr(pos + 1);
+  pos = name.find_last_of('.');
+  if (pos != std::string::npos) name = name.substr(0, pos);
+
+  std::string font_name;
+  for (char ch : name) if (isalnum((unsigned char) ch)) font_name += ch;
+  font_name += "SDF" + std::to_string(size);
+
+  FT_Library library;
+  FT_Face    face;
+  FT_Int     sdf_spread = spread;
+
+  if (FT_Init_FreeType(&library) || FT_Property_Set(library, "sdf", "spread", &sdf_spread)) {
+    fprintf(stderr, "FreeType initialization error (SDF support requires version 2.11 or later).\n");
+    return 1;
+  }
+  if (FT_New_Face(library, argv[1], 0, &face)) {
+    fprintf(stderr, "Unable to load font file %s.\n", argv[1]);
+    FT_Done_FreeType(library);
+    return 1;
+  }
+  if (FT_Set_Pixel_Sizes(face, 0, size)) {
+    fprintf(stderr, "Unable to set the font size.\n");
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return 1;
+  }
+
+  std::vector<uint8_t> bitmap;
+  std::vector<Glyph>   glyphs;
+
+  for (int c = first; c <= last; c++) {
+    Glyph glyph = { (uint32_t) bitmap.size(), 0, 0, 0, 0, 0 };
+
+    // Not hinted: hinting is specific to the size the fields are computed at
+
+    if (FT_Load_Char(face, c, FT_LOAD_NO_HINTING)) {
+      fprintf(stderr, "Unable to load character 0x%02X, left empty.\n", c);
+      glyphs.push_back(glyph);
+      continue;
+    }
+
+    FT_GlyphSlot slot = face->glyph;
+
+    // Advances are kept in 1/16 pixels: they are scaled at rendering time
+
+    glyph.x_advance = (slot->advance.x + 2) >> 2;
+
+    // Glyphs without outline (space) have no distance field
+
+    if ((slot->outline.n_points > 0) && (FT_Render_Glyph(slot, FT_RENDER_MODE_SDF) == 0)) {
+      FT_Bitmap & bm = slot->bitmap;
+
+      if ((bm.width > 255) || (bm.rows > 255)) {
+        fprintf(stderr, "Character 0x%02X too large, left empty.\n", c);
+      }
+      else {
+        glyph.width    = bm.width;
+        glyph.height   = bm.rows;
+        glyph.x_offset = slot->bitmap_left;
+        glyph.y_offset = 1 - slot->bitmap_top;
+
+        // FreeType gives 128 on the outline, plus or minus 128 / spread
+        // per pixel inside or outside: the SDFFont convention
+
+        for (unsigned int j = 0; j < bm.rows; j++) {
+          bitmap.insert(bitmap.end(), &bm.buffer[j * bm.pitch], &bm.buffer[j * bm.pitch] + bm.width);
+        }
+      }
+    }
+
+    glyphs.push_back(glyph);
+  }
+
+  printf("const uint8_t %sBitmaps[] PROGMEM = {", font_name.c_str());
+  for (size_t i = 0; i < bitmap.size(); i++) {
+    printf("%s0x%02X%s", (i % 12) ? " " : "\n  ", bitmap[i], (i + 1 < bitmap.size()) ? "," : "");
+  }
+  printf(" };\n\n");
+
+  printf("const SDFGlyph %sGlyphs[] PROGMEM = {\n", font_name.c_str());
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    const Glyph & g = glyphs[i];
+    int           c = first + i;
+    printf("  { %6u, %3d, %3d, %5d, %4d, %4d }%s // 0x%02X", g.offset, g.width, g.height, g.x_advance,
+           g.x_offset, g.y_offset, (i + 1 < glyphs.size()) ? ",  " : " };", c);
+    if ((c >= 0x20) && (c <= 0x7E)) printf(" '%c'", c);
+    printf("\n");
+  }
+
+  printf("\nconst SDFFont %s PROGMEM = {\n", font_name.c_str());
+  printf("  (uint8_t  *)%sBitmaps,\n", font_name.c_str());
+  printf("  (SDFGlyph *)%sGlyphs,\n", font_name.c_str());
+  printf("  0x%02X, 0x%02X, %d, %ld, %d };\n\n", first, last, size, face->size->metrics.height >> 6, spread);
+  printf("// Approx. %u bytes\n", (unsigned int) (bitmap.size() + glyphs.size() * 12 + 16));
+
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+
+  return 0;
+}